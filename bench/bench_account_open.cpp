@@ -0,0 +1,71 @@
+/// \file bench_account_open.cpp
+#include "benchmark.hpp"
+#include "io1/account.hpp"
+#include "io1/archive_writer.hpp"
+#include <boost/filesystem/operations.hpp>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  // Evicts the file from the page cache, so that the next read comes from the disk.
+  void drop_from_cache(boost::filesystem::path const & filename)
+  {
+    auto const fd = ::open(filename.c_str(), O_RDONLY);
+    if (0 > fd) return;
+
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+int main(void)
+{
+  std::size_t const year_count = 15;
+  std::size_t const statements_per_year = 40'000;
+  boost::filesystem::path const account_filename = "bench_account_open.act";
+
+  // an account with one archive of a few megabytes per year.
+  std::vector<boost::filesystem::path> filenames{ account_filename, "bench_account_open.lst" };
+  for (std::size_t year = 0; year_count > year; ++year) filenames.push_back("bench_account_open_" + std::to_string(year) + ".lst");
+  for (auto const & filename : filenames) boost::filesystem::remove(filename);
+
+  {
+    io1::Account account{ io1::Money{ 0 }, QDate{ 2000, 1, 1 } };
+    account.set_name("bench_account_open");
+    auto & listing = account.current_listing();
+    for (std::size_t year = 0; year_count > year; ++year)
+    {
+      QDate const origin{ 2001 + static_cast<int>(year), 1, 1 };
+      for (std::size_t i = 0; statements_per_year > i; ++i)
+        listing.set_committed(listing.add_statement(io1::Money{ static_cast<std::int64_t>(i % 100'000) }, QString("Some typical bank statement description"), origin.addDays(static_cast<qint64>(i * 365 / statements_per_year))));
+      account.archive(QString::fromStdString("bench_account_open_" + std::to_string(year)), io1::ArchiveWriter::default_memory_budget);
+    }
+    io1::save_as(account_filename, account);
+  }
+
+  std::size_t size = 0;
+  for (auto const & filename : filenames) size += static_cast<std::size_t>(boost::filesystem::file_size(filename));
+
+  using verification_type = io1::OpenOptions::verification_type;
+  std::pair<verification_type, char const *> const modes[] = { { verification_type::serial, "serial" }, { verification_type::parallel, "parallel" }, { verification_type::deferred, "deferred" } };
+
+  std::size_t checksum = 0;
+  for (bool const cold : { true, false })
+  {
+    for (auto const & [verification, name] : modes)
+    {
+      if (cold) for (auto const & filename : filenames) drop_from_cache(filename);
+      auto const seconds = io1::bench::time([&] { checksum += io1::open(account_filename, { verification }).archived_listings().size(); });
+      io1::bench::report(std::string("open, ") + name + (cold ? " (cold cache)" : " (warm cache)"), size, "bytes", seconds);
+    }
+  }
+
+  for (auto const & filename : filenames) boost::filesystem::remove(filename);
+  return (2 * std::size(modes) * year_count == checksum) ? 0 : 1;
+}
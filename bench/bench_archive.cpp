@@ -0,0 +1,90 @@
+/// \file bench_archive.cpp
+#include "benchmark.hpp"
+#include "io1/account.hpp"
+#include <boost/filesystem/operations.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/numeric.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  // live and peak heap usage, tracked through a size header in front of each allocation.
+  std::size_t live_bytes = 0;
+  std::size_t peak_bytes = 0;
+  constexpr std::size_t header_size = alignof(std::max_align_t);
+}
+
+void * operator new(std::size_t size)
+{
+  auto const block = static_cast<char *>(std::malloc(size + header_size));
+  if (!block) throw std::bad_alloc();
+
+  *reinterpret_cast<std::size_t *>(block) = size;
+  live_bytes += size;
+  peak_bytes = std::max(peak_bytes, live_bytes);
+  return block + header_size;
+}
+
+void operator delete(void * pointer) noexcept
+{
+  if (!pointer) return;
+
+  auto const block = static_cast<char *>(pointer) - header_size;
+  live_bytes -= *reinterpret_cast<std::size_t *>(block);
+  std::free(block);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept { operator delete(pointer); }
+
+int main(void)
+{
+  using statement_type = io1::Listing<io1::committable_tag>::statement_type;
+  std::size_t const count = 200'000;
+
+  // a year of statements where three out of four are committed, the others wait in the current listing.
+  QDate const origin{ 2014, 1, 1 };
+  io1::Account account{ io1::Money{ 0 }, origin };
+  auto & reference = account.current_listing();
+  for (std::size_t i = 0; count > i; ++i)
+  {
+    auto const statement = reference.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement of the year"), origin.addDays(static_cast<qint64>(i * 365 / count)));
+    if (0 != i % 4) reference.set_committed(statement);
+  }
+
+  auto copied = reference;
+  auto const copied_base = live_bytes;
+  peak_bytes = live_bytes;
+  io1::Money copied_balance{ 0 };
+  auto const copied_seconds = io1::bench::time([&]
+  {
+    // what Account::archive used to do: two filtered copies, a sort and a third pass for the balance.
+    auto const statement_at = [&copied](std::size_t position) -> statement_type const & { return copied.begin()[position]; };
+    auto const committed_range = copied.committed_statements() | boost::adaptors::transformed(statement_at);
+    io1::Listing<io1::non_committable_tag> archived_listing(QString("archive"), committed_range);
+    archived_listing.stable_sort();
+
+    auto const uncommitted = copied.uncommitted_statements();
+    auto const uncommitted_range = uncommitted | boost::adaptors::transformed(statement_at);
+    io1::Listing<io1::committable_tag> new_current_listing(copied.name(), uncommitted_range);
+
+    copied_balance = boost::accumulate(archived_listing.statements(), io1::Money{ 0 }, [](io1::Money acc, io1::Statement const & statement) { return acc += statement.amount(); });
+    std::swap(copied, new_current_listing);
+  });
+  io1::bench::report("filtered copies", count, "statements", copied_seconds);
+  std::cout << std::format("{:<40}{:>12} bytes\n", "  peak memory added", peak_bytes - copied_base);
+
+  // what Account::archive does: the file is streamed from the current listing, then the committed statements are moved into the archive.
+  boost::filesystem::remove("bench_archive.lst");
+  auto const archived_base = live_bytes;
+  peak_bytes = live_bytes;
+  auto const archived_seconds = io1::bench::time([&] { account.archive(QString("bench_archive")); });
+  io1::bench::report("Account::archive", count, "statements", archived_seconds);
+  std::cout << std::format("{:<40}{:>12} bytes\n", "  peak memory added", peak_bytes - archived_base);
+  boost::filesystem::remove("bench_archive.lst");
+
+  // the initial balance statement of the account is committed, the copies archived it as well.
+  return (copied == account.current_listing() && copied_balance == account.archived_balance()) ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/// \file bench_archive_load.cpp
+#include "benchmark.hpp"
+#include "io1/archive_cache.hpp"
+#include "io1/archived_listing.hpp"
+#include "io1/checksum.hpp"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  // Evicts the file from the page cache, so that the next read comes from the disk.
+  void drop_from_cache(boost::filesystem::path const & filename)
+  {
+    auto const fd = ::open(filename.c_str(), O_RDONLY);
+    if (0 > fd) return;
+
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+
+  // Loads a listing and its SHA-1 through the filter chain, as ArchivedListing::listing used to.
+  std::pair<io1::ArchivedListing::listing_type, io1::Checksum> load_through_filter(boost::filesystem::path const & filename)
+  {
+    boost::filesystem::ifstream file{ filename };
+    boost::iostreams::filtering_istream in;
+    io1::ChecksumFilter const filter;
+    in.push(filter);
+    in.push(file);
+
+    auto listing = io1::ArchivedListing::listing_type::read(in);
+    return { std::move(listing), filter.checksum() };
+  }
+}
+
+int main(void)
+{
+  std::size_t const count = 200'000;
+  boost::filesystem::path const filename = "bench_archive_load.lst";
+  boost::filesystem::remove(filename);
+
+  // a multi-megabyte archive, with a composed statement every 10 statements.
+  QDate const origin{ 2014, 1, 1 };
+  io1::ArchivedListing::listing_type listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i)
+  {
+    auto const date = origin.addDays(static_cast<qint64>(i * 365 / count));
+    if (0 == i % 10)
+    {
+      std::vector<io1::Entry> entries;
+      entries.emplace_back(io1::Money{ static_cast<std::int64_t>(i) }, "Some typical cheque deposit", date);
+      entries.emplace_back(io1::Money{ 100 }, "Some other typical cheque deposit", date);
+      listing.add_statement(QString("Some typical bank statement description"), date, entries);
+    }
+    else listing.add_statement(io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, QString("Some typical bank statement description"), date);
+  }
+
+  QDate const final_date = origin.addDays(364);
+  auto const final_balance = listing.total_amount();
+  io1::ArchivedListing(filename, listing, final_date, final_balance);
+
+  // each archive is created with its listing unloaded.
+  auto const sha1 = load_through_filter(filename).second;
+  auto const archive = [&] { return io1::ArchivedListing(filename, final_date, final_balance, sha1); };
+  auto const size = static_cast<std::size_t>(boost::filesystem::file_size(filename));
+
+  std::size_t checksum = 0;
+  for (bool const cold : { true, false })
+  {
+    auto const label = std::string(cold ? " (cold cache)" : " (warm cache)");
+
+    if (cold) drop_from_cache(filename);
+    auto const filter_seconds = io1::bench::time([&] { auto const [loaded, loaded_sha1] = load_through_filter(filename); checksum += (sha1 == loaded_sha1) ? loaded.statements().size() : 1; });
+    io1::bench::report("filter chain" + label, size, "bytes", filter_seconds);
+
+    auto const mapped = archive();
+    if (cold) drop_from_cache(filename);
+    auto const mapped_seconds = io1::bench::time([&] { checksum -= io1::ArchiveCache().listing(mapped)->statements().size(); });
+    io1::bench::report("mapped file" + label, size, "bytes", mapped_seconds);
+  }
+
+  boost::filesystem::remove(filename);
+  return (0 == checksum) ? 0 : 1;
+}
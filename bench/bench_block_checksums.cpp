@@ -0,0 +1,49 @@
+/// \file bench_block_checksums.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <iterator>
+#include <string>
+
+int main(void)
+{
+  std::size_t const count = 1'000'000;
+  std::size_t const edit_count = 1'000;
+
+  io1::Listing<io1::committable_tag> listing("bench");
+  for (std::size_t i = 0; count > i; ++i) listing.add_statement(io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, QString("Some typical bank statement description"), QDate{ 2020, 1, 1 }.addDays(static_cast<qint64>(i / 1000)));
+
+  std::size_t checksum = 0;
+
+  // what protecting the listing with a single checksum costs after any edit.
+  std::string buffer;
+  auto const whole_seconds = io1::bench::time([&]
+  {
+    buffer.clear();
+    listing.format_to(std::back_inserter(buffer));
+    checksum += io1::checksum(io1::HashAlgorithm::sha1, buffer).digest().size();
+  });
+  io1::bench::report("whole listing", count, "statements", whole_seconds);
+
+  auto const first_seconds = io1::bench::time([&] { checksum += listing.block_checksums(io1::HashAlgorithm::sha1).blocks().size(); });
+  io1::bench::report("blocks, first computation", count, "statements", first_seconds);
+
+  // one statement altered between two verifications, spread over the listing.
+  auto const edit_seconds = io1::bench::time([&]
+  {
+    for (std::size_t i = 0; edit_count > i; ++i)
+    {
+      auto const position = listing.begin() + static_cast<std::ptrdiff_t>((i * 7919) % count);
+      listing.alter_statement(position, position->amount() + io1::Money{ 1 }, position->description(), position->date());
+      checksum += listing.block_checksums(io1::HashAlgorithm::sha1).root().digest().size();
+    }
+  });
+  io1::bench::report("blocks, after a one line edit", edit_count, "verifications", edit_seconds);
+
+  // the incremental checksums must match the ones of a fresh listing.
+  buffer.clear();
+  listing.format_to(std::back_inserter(buffer));
+  auto const fresh = io1::Listing<io1::committable_tag>::read(buffer);
+  if (fresh.block_checksums(io1::HashAlgorithm::sha1).root() != listing.block_checksums(io1::HashAlgorithm::sha1).root()) return 1;
+
+  return (40 + (count + io1::BlockChecksums::default_block_size - 1) / io1::BlockChecksums::default_block_size + 40 * edit_count == checksum) ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+/// \file bench_checksum.cpp
+#include "benchmark.hpp"
+#include "io1/checksum.hpp"
+#include <string>
+
+int main(void)
+{
+  std::size_t const size = std::size_t{ 256 } << 20;
+  std::size_t const repeat = 4;
+
+  // listing text is mostly digits, dates and repeated descriptions, any content hashes at the same speed.
+  std::string bytes(size, '\0');
+  for (std::size_t i = 0; size > i; ++i) bytes[i] = static_cast<char>((i * 2654435761u) >> 24);
+
+  std::size_t checksum = 0;
+  auto const run = [&](std::string const & name, io1::HashAlgorithm algorithm)
+  {
+    std::string first_digest;
+    auto const seconds = io1::bench::time([&]
+    {
+      for (std::size_t i = 0; repeat > i; ++i)
+      {
+        auto const digest = io1::checksum(algorithm, bytes).digest();
+        if (first_digest.empty()) first_digest = digest;
+        checksum += (digest == first_digest) ? 1 : 0;
+      }
+    });
+    io1::bench::report(name, repeat * size, "bytes", seconds);
+    return first_digest;
+  };
+
+  // the portable and accelerated SHA-1 must agree.
+  auto const accelerated = io1::sha1_acceleration();
+  io1::set_sha1_acceleration(false);
+  auto const portable_digest = run("sha1 (portable)", io1::HashAlgorithm::sha1);
+  io1::set_sha1_acceleration(true);
+  if (accelerated && portable_digest != run("sha1 (sha instructions)", io1::HashAlgorithm::sha1)) return 1;
+
+  run("xxh64", io1::HashAlgorithm::xxh64);
+
+  return ((accelerated ? 3 : 2) * repeat == checksum) ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+/// \file bench_columnar_archive.cpp
+#include "benchmark.hpp"
+#include "io1/archive_cache.hpp"
+#include "io1/archived_listing.hpp"
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+int main(void)
+{
+  std::size_t const count = 200'000;
+  boost::filesystem::path const text_filename = "bench_columnar_archive.lst";
+  boost::filesystem::path const columnar_filename = "bench_columnar_archive.col";
+  for (auto const & filename : { text_filename, columnar_filename }) boost::filesystem::remove(filename);
+
+  // ten years of statements, with a composed statement every 10 statements.
+  QDate const origin{ 2014, 1, 1 };
+  io1::ArchivedListing::listing_type listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i)
+  {
+    auto const date = origin.addDays(static_cast<qint64>(i * 3650 / count));
+    if (0 == i % 10)
+    {
+      std::vector<io1::Entry> entries;
+      entries.emplace_back(io1::Money{ static_cast<std::int64_t>(i) }, "Some typical cheque deposit", date);
+      entries.emplace_back(io1::Money{ 100 }, "Some other typical cheque deposit", date);
+      listing.add_statement(QString("Some typical bank statement description"), date, entries);
+    }
+    else listing.add_statement(io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, QString("Some typical bank statement description"), date);
+  }
+
+  QDate const final_date = origin.addDays(3649);
+  auto const final_balance = listing.total_amount();
+  auto const text_sha1 = io1::ArchivedListing(text_filename, listing, final_date, final_balance).checksum();
+  auto const columnar_sha1 = io1::ArchivedListing(columnar_filename, listing, final_date, final_balance, io1::HashAlgorithm::sha1, io1::ArchivedListing::format_type::columnar).checksum();
+
+  auto const text_size = static_cast<std::size_t>(boost::filesystem::file_size(text_filename));
+  auto const columnar_size = static_cast<std::size_t>(boost::filesystem::file_size(columnar_filename));
+  std::cout << "text archive: " << text_size << " bytes, columnar archive: " << columnar_size << " bytes\n";
+
+  // each archive is created with its listing unloaded, and hashed when it is loaded.
+  auto const deferred = io1::ArchivedListing::verification_type::deferred;
+  auto const text = [&] { return io1::ArchivedListing(text_filename, final_date, final_balance, text_sha1, deferred); };
+  auto const columnar = [&] { return io1::ArchivedListing(columnar_filename, final_date, final_balance, columnar_sha1, deferred); };
+
+  std::size_t checksum = 0;
+  auto const text_load_seconds = io1::bench::time([&] { checksum += io1::ArchiveCache().listing(text())->statements().size(); });
+  io1::bench::report("text, whole listing", count, "statements", text_load_seconds);
+
+  auto const columnar_load_seconds = io1::bench::time([&] { checksum -= io1::ArchiveCache().listing(columnar())->statements().size(); });
+  io1::bench::report("columnar, whole listing", count, "statements", columnar_load_seconds);
+
+  // one month out of ten years.
+  std::chrono::year_month_day const from = std::chrono::year{ 2019 } / 3 / 1;
+  std::chrono::year_month_day const to = std::chrono::year{ 2019 } / 3 / 31;
+
+  auto const text_range_seconds = io1::bench::time([&] { checksum += text().statements_between(from, to).size(); });
+  io1::bench::report("text, one month", 1, "queries", text_range_seconds);
+
+  auto const columnar_range_seconds = io1::bench::time([&] { checksum -= columnar().statements_between(from, to).size(); });
+  io1::bench::report("columnar, one month", 1, "queries", columnar_range_seconds);
+
+  for (auto const & filename : { text_filename, columnar_filename }) boost::filesystem::remove(filename);
+  return (0 == checksum) ? 0 : 1;
+}
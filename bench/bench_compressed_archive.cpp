@@ -0,0 +1,105 @@
+/// \file bench_compressed_archive.cpp
+#include "benchmark.hpp"
+#include "io1/archive_cache.hpp"
+#include "io1/archived_listing.hpp"
+#include "io1/columnar_archive.hpp"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  // Evicts the file from the page cache, so that the next read comes from the disk.
+  void drop_from_cache(boost::filesystem::path const & filename)
+  {
+    auto const fd = ::open(filename.c_str(), O_RDONLY);
+    if (0 > fd) return;
+
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+
+  std::string read_file(boost::filesystem::path const & filename)
+  {
+    boost::filesystem::ifstream file{ filename, std::ios::binary };
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+}
+
+int main(void)
+{
+  std::size_t const count = 500'000;
+  using format_type = io1::ArchivedListing::format_type;
+  std::array<std::pair<format_type, boost::filesystem::path>, 3> const archives{ {
+    { format_type::text, "bench_compressed_archive.lst" },
+    { format_type::columnar, "bench_compressed_archive.col" },
+    { format_type::compressed, "bench_compressed_archive.cmp" } } };
+  for (auto const & [format, filename] : archives) boost::filesystem::remove(filename);
+
+  // ten years of an account: a few statements a day to a handful of payees, and a deposit of numbered cheques every 20 statements.
+  std::array<char const *, 12> const payees{ "CARTE 1234 SUPERMARCHE DU CENTRE", "PRLV SEPA ELECTRICITE DE FRANCE", "PRLV SEPA OPERATEUR MOBILE",
+    "CARTE 1234 STATION SERVICE", "VIR SEPA SALAIRE", "CARTE 1234 BOULANGERIE", "PRLV SEPA ASSURANCE HABITATION", "RETRAIT DAB 1234",
+    "CARTE 1234 PHARMACIE", "CARTE 1234 LIBRAIRIE", "VIR SEPA LOYER", "COTISATION CARTE" };
+  std::uint64_t random = 42;
+  auto const next = [&random] { random = random * 6364136223846793005 + 1442695040888963407; return random >> 33; };
+
+  QDate const origin{ 2014, 1, 1 };
+  io1::ArchivedListing::listing_type listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i)
+  {
+    auto const date = origin.addDays(static_cast<qint64>(i * 3650 / count));
+    if (0 == i % 20)
+    {
+      std::vector<io1::Entry> entries;
+      for (std::size_t cheque = 0; 1 + next() % 3 > cheque; ++cheque) entries.emplace_back(io1::Money{ static_cast<std::int64_t>(next() % 50'000) }, "CHEQUE " + std::to_string(1'000'000 + i + cheque), date);
+      listing.add_statement(QString("REMISE DE CHEQUES"), date, entries);
+    }
+    else listing.add_statement(io1::Money{ -static_cast<std::int64_t>(next() % 20'000) }, QString(payees[next() % payees.size()]), date);
+  }
+
+  QDate const final_date = origin.addDays(3649);
+  auto const final_balance = listing.total_amount();
+  std::array<io1::Checksum, 3> checksums;
+  std::array<std::size_t, 3> sizes{};
+  for (std::size_t i = 0; archives.size() > i; ++i)
+  {
+    checksums[i] = io1::ArchivedListing(archives[i].second, listing, final_date, final_balance, io1::HashAlgorithm::sha1, archives[i].first).checksum();
+    sizes[i] = static_cast<std::size_t>(boost::filesystem::file_size(archives[i].second));
+  }
+  std::cout << "text: " << sizes[0] << " bytes, columnar: " << sizes[1] << " bytes, compressed: " << sizes[2] << " bytes ("
+    << static_cast<double>(sizes[0]) / static_cast<double>(sizes[2]) << " times smaller than text)\n";
+
+  std::size_t checksum = 0;
+
+  // decoding alone, from memory.
+  auto const text = read_file(archives[0].second);
+  auto const text_seconds = io1::bench::time([&] { checksum += io1::ArchivedListing::listing_type::read(text).statements().size(); });
+  io1::bench::report("text, parse", text.size(), "bytes", text_seconds);
+
+  for (std::size_t i = 1; archives.size() > i; ++i)
+  {
+    auto const bytes = read_file(archives[i].second);
+    auto const seconds = io1::bench::time([&] { checksum -= io1::ColumnarArchive(bytes).listing().statements().size(); });
+    io1::bench::report(std::string((1 == i) ? "columnar" : "compressed") + ", decode", bytes.size(), "bytes", seconds);
+    io1::bench::report("  as text", text.size(), "bytes", seconds);
+  }
+
+  // a whole archive loaded from the disk, hashed and decoded.
+  for (std::size_t i = 0; archives.size() > i; ++i)
+  {
+    io1::ArchivedListing const archive(archives[i].second, final_date, final_balance, checksums[i], io1::ArchivedListing::verification_type::deferred);
+    drop_from_cache(archives[i].second);
+    auto const seconds = io1::bench::time([&] { checksum += io1::ArchiveCache().listing(archive)->statements().size(); });
+    io1::bench::report(std::string((0 == i) ? "text" : (1 == i) ? "columnar" : "compressed") + ", cold load", count, "statements", seconds);
+  }
+
+  for (auto const & [format, filename] : archives) boost::filesystem::remove(filename);
+  return (2 * count == checksum) ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+/// \file bench_entry_read.cpp
+#include "benchmark.hpp"
+#include "io1/entry.hpp"
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+int main(void)
+{
+  using namespace std::chrono;
+  std::size_t const count = 1'000'000;
+
+  std::string buffer;
+  {
+    std::ostringstream stream;
+    for (std::size_t i = 0; count > i; ++i)
+      io1::Entry{ io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, "Some typical bank statement description " + std::to_string(i % 97), sys_days{ 2020y / January / 1d } + days{ static_cast<int>(i % 1500) } }.write(stream);
+    buffer = std::move(stream).str();
+  }
+
+  std::size_t checksum = 0;
+  auto const stream_seconds = io1::bench::time([&]
+  {
+    std::istringstream stream(buffer);
+    for (std::size_t i = 0; count > i; ++i) checksum += io1::Entry::read(stream).description().size();
+  });
+  io1::bench::report("Entry::read(std::istream &)", count, "entries", stream_seconds);
+
+  auto const buffer_seconds = io1::bench::time([&]
+  {
+    std::string_view view = buffer;
+    io1::Entry entry;
+    while (!view.empty())
+    {
+      view.remove_prefix(io1::Entry::read(view, entry));
+      checksum -= entry.description().size();
+    }
+  });
+  io1::bench::report("Entry::read(std::string_view, Entry &)", count, "entries", buffer_seconds);
+
+  return (0 == checksum) ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+/// \file bench_gather_selection.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <boost/range/adaptor/reversed.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace
+{
+  using listing_type = io1::Listing<io1::committable_tag>;
+
+  // Selects count statements spread at random over the listing.
+  listing_type::statement_selection select(listing_type const & listing, std::size_t count)
+  {
+    std::mt19937 generator{ 42 };
+    std::uniform_int_distribution<std::size_t> distribution{ 0, listing.statements().size() - 1 };
+
+    listing_type::statement_selection selection;
+    selection.reserve(count);
+    while (count > selection.size()) selection.insert(listing.begin() + static_cast<std::ptrdiff_t>(distribution(generator)));
+    return selection;
+  }
+}
+
+int main(void)
+{
+  std::size_t const count = 200'000;
+
+  QDate const origin{ 2014, 1, 1 };
+  listing_type reference{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i) reference.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement"), origin.addDays(static_cast<qint64>(i / 100)));
+
+  bool same = true;
+  for (std::size_t selected : { std::size_t{ 10 }, std::size_t{ 1'000 }, std::size_t{ 100'000 } })
+  {
+    auto listing = reference;
+    auto const selection = select(listing, selected);
+    auto const seconds = io1::bench::time([&] { listing.gather_selection(selection); });
+    io1::bench::report("gather_selection, k = " + std::to_string(selected), selected, "statements", seconds);
+
+    // one rotate per selected statement, as gather_selection used to do. Too slow to run for the largest selection.
+    if (1'000 < selected) continue;
+    auto rotated = reference;
+    auto const rotated_selection = select(rotated, selected);
+    auto const rotate_seconds = io1::bench::time([&]
+    {
+      auto position = *rotated_selection.rbegin() + 1;
+      for (auto statement : rotated_selection | boost::adaptors::reversed) rotated.move_statement_up(statement, --position);
+    });
+    io1::bench::report("repeated rotates, k = " + std::to_string(selected), selected, "statements", rotate_seconds);
+    same = same && (rotated == listing);
+  }
+
+  return same ? 0 : 1;
+}
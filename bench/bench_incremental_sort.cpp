@@ -0,0 +1,32 @@
+/// \file bench_incremental_sort.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <boost/range/algorithm/equal.hpp>
+#include <boost/range/algorithm/stable_sort.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+int main(void)
+{
+  std::size_t const count = 500'000;
+  std::size_t const appended = 500;
+
+  std::mt19937 generator{ 42 };
+  std::uniform_int_distribution<qint64> day_distribution{ 0, 10 * 365 };
+
+  // a sorted listing to which a few statements are appended in random order.
+  QDate const origin{ 2014, 1, 1 };
+  io1::Listing<io1::committable_tag> listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i) listing.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement"), origin.addDays(static_cast<qint64>(i * 10 * 365 / count)));
+  for (std::size_t i = 0; appended > i; ++i) listing.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("appended"), origin.addDays(day_distribution(generator)));
+
+  std::vector<io1::Statement> statements(listing.statements().begin(), listing.statements().end());
+  auto const full_seconds = io1::bench::time([&] { boost::range::stable_sort(statements, [](auto const & lhs, auto const & rhs) { return lhs.date() < rhs.date(); }); });
+  io1::bench::report("full stable_sort", count + appended, "statements", full_seconds);
+
+  auto const incremental_seconds = io1::bench::time([&] { listing.stable_sort(); });
+  io1::bench::report("incremental stable_sort", count + appended, "statements", incremental_seconds);
+
+  return boost::range::equal(statements, listing.statements()) ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+/// \file bench_listing_columns.cpp
+#include "benchmark.hpp"
+#include "io1/listing_columns.hpp"
+#include <cstdint>
+
+int main(void)
+{
+  using namespace std::chrono;
+  std::size_t const count = 10'000'000;
+
+  io1::ListingColumns columns;
+  columns.reserve(count);
+  for (std::size_t i = 0; count > i; ++i)
+    columns.push_back(io1::Entry{ io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, "description", sys_days{ 2000y / January / 1d } + days{ static_cast<int>(i / 1000) } }, 0 == i % 2);
+
+  auto const amount_bytes = count * sizeof(io1::ListingColumns::amount_type);
+  auto const day_bytes = count * sizeof(io1::ListingColumns::day_type);
+  std::int64_t checksum = 0;
+
+  auto const sum_seconds = io1::bench::time([&] { checksum += columns.sum().data(); });
+  io1::bench::report("sum", amount_bytes, "bytes", sum_seconds);
+
+  auto const minmax_seconds = io1::bench::time([&] { checksum += columns.minmax_amount().second.data(); });
+  io1::bench::report("minmax_amount", amount_bytes, "bytes", minmax_seconds);
+
+  auto const range_seconds = io1::bench::time([&] { checksum += columns.sum(2010y / January / 1d, 2010y / December / 31d).data(); });
+  io1::bench::report("sum over a date range", amount_bytes + day_bytes, "bytes", range_seconds);
+
+  auto const filter_seconds = io1::bench::time([&] { checksum += static_cast<std::int64_t>(columns.filter(2010y / January / 1d, 2010y / December / 31d).size()); });
+  io1::bench::report("filter by date range", day_bytes, "bytes", filter_seconds);
+
+  auto const committed_seconds = io1::bench::time([&] { checksum += static_cast<std::int64_t>(columns.committed_count()); });
+  io1::bench::report("committed_count", count / 8, "bytes", committed_seconds);
+
+  return (0 != checksum) ? 0 : 1;
+}
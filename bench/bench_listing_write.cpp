@@ -0,0 +1,47 @@
+/// \file bench_listing_write.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+int main(void)
+{
+  std::size_t const count = 100'000;
+
+  io1::Listing<io1::committable_tag> listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i)
+  {
+    auto const statement = listing.add_statement(io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, QString("Some typical bank statement description"), QDate{ 2020, 1, 1 }.addDays(static_cast<qint64>(i % 1500)));
+    if (0 == i % 3) listing.set_committed(statement);
+  }
+
+  std::size_t checksum = 0;
+
+  auto const statement_seconds = io1::bench::time([&]
+  {
+    std::ostringstream stream;
+    stream << "\n" << listing.name().toStdString() << "\n\n";
+    for (auto const & statement : listing) stream << statement;
+    checksum += stream.str().size();
+  });
+  io1::bench::report("operator<< on each statement", count, "statements", statement_seconds);
+
+  auto const listing_seconds = io1::bench::time([&]
+  {
+    std::ostringstream stream;
+    stream << listing;
+    checksum -= stream.str().size();
+  });
+  io1::bench::report("operator<< on the listing", count, "statements", listing_seconds);
+
+  std::string buffer;
+  auto const buffer_seconds = io1::bench::time([&]
+  {
+    listing.format_to(std::back_inserter(buffer));
+  });
+  io1::bench::report("Listing::format_to", count, "statements", buffer_seconds);
+
+  return (0 == checksum) ? 0 : 1;
+}
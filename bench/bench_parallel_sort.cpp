@@ -0,0 +1,35 @@
+/// \file bench_parallel_sort.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+
+int main(void)
+{
+  std::size_t const count = 2'000'000;
+
+  std::mt19937 generator{ 42 };
+  std::uniform_int_distribution<qint64> day_distribution{ 0, 10 * 365 };
+
+  QDate const origin{ 2014, 1, 1 };
+  io1::Listing<io1::committable_tag> unsorted{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i) unsorted.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement"), origin.addDays(day_distribution(generator)));
+
+  // the single threaded sort is the reference, every thread count must give the same listing.
+  auto reference = unsorted;
+  auto const reference_seconds = io1::bench::time([&] { reference.stable_sort(); });
+  io1::bench::report("stable_sort, 1 thread", count, "statements", reference_seconds);
+
+  bool same = true;
+  for (unsigned thread_count : { 2u, 4u, 8u, std::max(1u, std::thread::hardware_concurrency()) })
+  {
+    auto listing = unsorted;
+    auto const seconds = io1::bench::time([&] { listing.stable_sort(thread_count); });
+    io1::bench::report("stable_sort, " + std::to_string(thread_count) + " threads", count, "statements", seconds);
+    same = same && (reference == listing);
+  }
+
+  return same ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+/// \file bench_running_balance.cpp
+#include "benchmark.hpp"
+#include "io1/running_balance.hpp"
+#include <boost/range/numeric.hpp>
+#include <cstdint>
+#include <vector>
+
+int main(void)
+{
+  std::size_t const count = 1'000'000;
+
+  std::vector<io1::Entry> entries;
+  entries.reserve(count);
+  for (std::size_t i = 0; count > i; ++i) entries.emplace_back(io1::Money{ static_cast<std::int64_t>(i % 100'000) - 50'000 }, "description");
+
+  io1::ListingColumns columns;
+  columns.reserve(count);
+  for (auto const & entry : entries) columns.push_back(entry, false);
+
+  std::vector<io1::balance_type> balances(count);
+  std::int64_t checksum = 0;
+
+  // what Account::balance() does on every call.
+  auto const accumulate_seconds = io1::bench::time([&]
+  {
+    checksum += boost::accumulate(entries, io1::Money{ 0 }, [](io1::Money total, io1::Entry const & entry) { return total += entry.amount(); }).data();
+  });
+  io1::bench::report("boost::accumulate over statements", count, "statements", accumulate_seconds);
+
+  auto const scalar_seconds = io1::bench::time([&] { io1::running_balance_scalar(columns.amounts(), 0, balances); });
+  checksum -= balances.back();
+  io1::bench::report("running_balance_scalar", count, "statements", scalar_seconds);
+
+  auto const kernel_seconds = io1::bench::time([&] { io1::running_balance(columns.amounts(), 0, balances); });
+  checksum -= balances.back();
+  io1::bench::report(io1::running_balance_uses_avx2() ? "running_balance (AVX2)" : "running_balance (scalar)", count, "statements", kernel_seconds);
+
+  return (-checksum == balances.back()) ? 0 : 1;
+}
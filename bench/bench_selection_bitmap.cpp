@@ -0,0 +1,39 @@
+/// \file bench_selection_bitmap.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <cstdint>
+
+int main(void)
+{
+  std::size_t const count = 200'000;
+
+  QDate const origin{ 2014, 1, 1 };
+  io1::Listing<io1::committable_tag> listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i)
+  {
+    auto const statement = listing.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement"), origin.addDays(static_cast<qint64>(i / 100)));
+    if (0 != i % 2) listing.set_committed(statement);
+  }
+
+  // select all uncommitted statements, one insert at a time into the flat set as a caller would.
+  io1::Listing<io1::committable_tag>::statement_selection selection;
+  auto const set_seconds = io1::bench::time([&]
+  {
+    for (auto statement = listing.begin(); listing.end() != statement; ++statement)
+      if (!listing.is_committed(statement)) selection.insert(statement);
+  });
+  io1::bench::report("statement_selection", count, "statements", set_seconds);
+
+  io1::SelectionBitmap bitmap;
+  auto const bitmap_seconds = io1::bench::time([&] { bitmap = listing.uncommitted_statements(); });
+  io1::bench::report("uncommitted_statements", count, "statements", bitmap_seconds);
+
+  std::size_t iterated = 0;
+  auto const iterate_seconds = io1::bench::time([&] { for (auto position : bitmap) iterated += position; });
+  io1::bench::report("bitmap iteration", bitmap.count(), "statements", iterate_seconds);
+
+  auto const gather_seconds = io1::bench::time([&] { listing.gather_selection(bitmap); });
+  io1::bench::report("gather_selection", bitmap.count(), "statements", gather_seconds);
+
+  return (selection.size() == bitmap.count() && 0 != iterated) ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+/// \file bench_statements_between.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <boost/range/algorithm/count_if.hpp>
+#include <cstdint>
+#include <random>
+
+int main(void)
+{
+  std::size_t const count = 1'000'000;
+  std::size_t const queries = 100;
+
+  std::mt19937 generator{ 42 };
+  std::uniform_int_distribution<qint64> day_distribution{ 0, 10 * 365 };
+
+  QDate const origin{ 2014, 1, 1 };
+  io1::Listing<io1::committable_tag> listing{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i) listing.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement"), origin.addDays(day_distribution(generator)));
+
+  std::size_t linear_count = 0;
+  auto const linear_seconds = io1::bench::time([&]
+  {
+    for (std::size_t i = 0; queries > i; ++i)
+    {
+      auto const from = origin.addDays(static_cast<qint64>(30 * i));
+      auto const to = from.addDays(30);
+      linear_count += boost::count_if(listing.statements(), [&](auto const & statement) { return !(statement.date() < from) && !(to < statement.date()); });
+    }
+  });
+  io1::bench::report("linear scan", queries, "queries", linear_seconds);
+
+  auto const build_seconds = io1::bench::time([&] { listing.statements_between(origin, origin); });
+  io1::bench::report("date index build", count, "statements", build_seconds);
+
+  std::size_t indexed_count = 0;
+  auto const indexed_seconds = io1::bench::time([&]
+  {
+    for (std::size_t i = 0; queries > i; ++i)
+    {
+      auto const from = origin.addDays(static_cast<qint64>(30 * i));
+      indexed_count += listing.statements_between(from, from.addDays(30)).size();
+    }
+  });
+  io1::bench::report("statements_between", queries, "queries", indexed_seconds);
+
+  return (linear_count == indexed_count) ? 0 : 1;
+}
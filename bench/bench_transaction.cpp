@@ -0,0 +1,48 @@
+/// \file bench_transaction.cpp
+#include "benchmark.hpp"
+#include "io1/listing.hpp"
+#include <boost/range/adaptor/reversed.hpp>
+#include <cstdint>
+#include <vector>
+
+int main(void)
+{
+  std::size_t const count = 200'000;
+  std::size_t const edits = 2'000;
+
+  QDate const origin{ 2014, 1, 1 };
+  io1::Listing<io1::committable_tag> reference{ "benchmark" };
+  for (std::size_t i = 0; count > i; ++i) reference.add_statement(io1::Money{ static_cast<std::int64_t>(i) }, QString("statement"), origin.addDays(static_cast<qint64>(i / 100)));
+
+  // every 100th statement is grouped with the next one, and the one after that is erased.
+  std::vector<std::size_t> positions;
+  for (std::size_t i = 0; edits > i; ++i) positions.push_back(i * (count / edits));
+
+  auto per_call = reference;
+  auto const per_call_seconds = io1::bench::time([&]
+  {
+    // from the end so that the positions still to edit are not shifted.
+    for (auto position : positions | boost::adaptors::reversed)
+    {
+      auto const statement = per_call.begin() + static_cast<std::ptrdiff_t>(position);
+      per_call.erase_statement(statement + 2);
+      per_call.group_range(QString("group"), origin, boost::make_iterator_range(statement, statement + 2));
+    }
+  });
+  io1::bench::report("per call edits", 2 * edits, "edits", per_call_seconds);
+
+  auto batched = reference;
+  auto const batched_seconds = io1::bench::time([&]
+  {
+    auto transaction = batched.transaction();
+    for (auto position : positions)
+    {
+      auto const statement = batched.begin() + static_cast<std::ptrdiff_t>(position);
+      transaction.group(QString("group"), origin, boost::make_iterator_range(statement, statement + 2)).erase(statement + 2);
+    }
+    transaction.commit();
+  });
+  io1::bench::report("transaction", 2 * edits, "edits", batched_seconds);
+
+  return (per_call == batched) ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+/// \file benchmark.hpp
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string_view>
+
+namespace io1::bench
+{
+  /// Runs f once and returns the elapsed wall clock time in seconds.
+  template<typename F> [[nodiscard]] double time(F && f)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    std::forward<F>(f)();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// Prints a line of the form "name: n items in x s (y items/s)".
+  inline void report(std::string_view name, std::size_t count, std::string_view unit, double seconds)
+  {
+    std::cout << std::format("{:<40}{:>12} {} in {:.4f} s ({:.3e} {}/s)\n", name, count, unit, seconds, static_cast<double>(count) / seconds, unit);
+  }
+}
@@ -6,12 +6,29 @@
 #include <io1/money.hpp>
 #include "io1/listing.hpp"
 #include "io1/archived_listing.hpp"
+#include "io1/archive_cache.hpp"
+#include "io1/checksum.hpp"
 
 #include <vector>
 #include <QString>
 #include <QDate>
 
 namespace io1 {
+
+  /// Options for reading an account.
+  struct OpenOptions
+  {
+    /// How the SHA-1 of each archive file is checked.
+    enum class verification_type
+    {
+      serial, /// archive files are hashed one after the other as they are read.
+      parallel, /// archive files are hashed concurrently once they are all read.
+      deferred, /// archive files are only hashed when their listing is first loaded.
+    };
+
+    verification_type archive_verification{ verification_type::parallel };
+    unsigned thread_count{ 0 }; /// Threads hashing archives in parallel mode, 0 for std::thread::hardware_concurrency().
+  };
   
   /// Models an account.
   ///
@@ -28,37 +45,63 @@ namespace io1 {
 
     Account & set_name(QString const & name) { current_listing_.set_name(name); return *this; };
     Account & set_description(QString const & description) { description_ = description; return *this; };
+    /// Changes the algorithm that protects the files written from now on, files already written keep theirs.
+    Account & set_hash_algorithm(HashAlgorithm algorithm) { hash_algorithm_ = algorithm; return *this; };
+    HashAlgorithm hash_algorithm(void) const { return hash_algorithm_; };
+    /// Cuts the current listing file into blocks of block_size statements, whose checksums are written in an index file next to it.
+    /// Saving after a few edits then only rehashes the blocks they changed, and a corrupted file is reported with the block at fault.
+    /// Zero, the default, protects the file with a single checksum.
+    Account & set_block_size(std::size_t block_size) { block_size_ = block_size; return *this; };
+    std::size_t block_size(void) const { return block_size_; };
+    /// Changes the format of the archives written from now on. Archives already written keep theirs, which is detected when they are read.
+    Account & set_archive_format(ArchivedListing::format_type format) { archive_format_ = format; return *this; };
+    ArchivedListing::format_type archive_format(void) const { return archive_format_; };
 
   public:
     current_listing_type & current_listing(void) { return current_listing_; };
     current_listing_type const & current_listing(void) const { return current_listing_; };
 
     std::vector<ArchivedListing> const & archived_listings(void) const { return archived_listings_; };
+    /// Returns the listing of the archive at index, loading it through the archive cache, which bounds the memory used by archived listings.
+    ArchivedListing::shared_listing_type archived_listing(std::size_t index) const;
+    ArchiveCache & archive_cache(void) const { return archive_cache_; }; /// The cache is not copied with the account, only its memory budget is.
 
     Money balance(void) const;
     Money archived_balance(void) const;
+    std::vector<ListingColumns::amount_type> running_balances(void) const; /// Returns the balance after each statement of the current listing, in cents.
 
+    /// Streams the committed statements into a new archive file, then moves them out of the current listing into the archive, which
+    /// keeps them in memory and enters the archive cache. The current listing is left untouched if the file cannot be written.
     void archive(QString name);
+    /// Streams the committed statements into a new archive file, sorting them in runs of at most memory_budget bytes. The archive
+    /// only keeps its file name, final date, balance and SHA-1, its listing is read from the file when it is first asked for.
+    void archive(QString name, std::size_t memory_budget);
 
   public:
     std::ostream & write(std::ostream & stream) const;
-    static Account read(std::istream & stream);
+    static Account read(std::istream & stream, OpenOptions const & options = {}); /// Reads the account, whose archives are checked as options tell.
 
   private:
     explicit Account(current_listing_type current_listing, std::vector<ArchivedListing> archives, QString description, QString currency = QString());
 
+    bool write_archive(QString const & name, std::size_t memory_budget); // Writes the committed statements into a new archive and adds it. Returns false if there are none.
+
   private:
     QString description_;
     QString currency_;
+    HashAlgorithm hash_algorithm_{ HashAlgorithm::sha1 }; // read back from the current listing line.
+    std::size_t block_size_{ 0 }; // read back from the block index, if the current listing line names one.
+    ArchivedListing::format_type archive_format_{ ArchivedListing::format_type::text };
     current_listing_type current_listing_;
     std::vector<ArchivedListing> archived_listings_;
+    mutable ArchiveCache archive_cache_;
   };
 
   std::ostream & operator<<(std::ostream & stream, Account const & account);
   std::istream & operator>>(std::istream & stream, Account & account);
 
   void save_as(boost::filesystem::path const & path, Account const & account);
-  io1::Account open(boost::filesystem::path const & path);
+  io1::Account open(boost::filesystem::path const & path, OpenOptions const & options = {});
 }
 
 #endif
\ No newline at end of file
@@ -29,5 +29,11 @@ namespace io1
     void format_message(void) const override;
   };
 
+  /// Exception thrown when a transaction is asked to erase, move, group or alter a statement it already edits.
+  struct StatementEditedTwice : virtual Exception
+  {
+    using errinfo_position = boost::error_info<struct tag_position, std::size_t>;
+    void format_message(void) const override;
+  };
 
 }
\ No newline at end of file
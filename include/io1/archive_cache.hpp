@@ -0,0 +1,70 @@
+/// \file archive_cache.hpp
+#pragma once
+#ifndef IO1_ARCHIVE_CACHE_HPP
+#define IO1_ARCHIVE_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "io1/archived_listing.hpp"
+
+namespace io1 {
+
+  /// Bounds the memory used by the listings of archives.
+  ///
+  /// Listings asked for through the cache are kept in memory until their total size exceeds the memory budget, the least recently
+  /// used ones are then released by their archives. A listing that is still referenced elsewhere stays alive until it is no longer
+  /// used, only the archive forgets it. The cache may be used from several threads at once.
+  class ArchiveCache
+  {
+  public:
+    static constexpr std::size_t default_memory_budget = std::size_t{ 256 } << 20;
+
+    struct statistics_type
+    {
+      std::size_t hits{ 0 }; // listings found in the cache.
+      std::size_t misses{ 0 }; // listings that had to be loaded.
+      std::size_t evictions{ 0 }; // listings released to fit the budget.
+    };
+
+  public:
+    explicit ArchiveCache(std::size_t memory_budget = default_memory_budget); /// Creates an empty cache.
+    ArchiveCache(ArchiveCache const & rhs); /// Creates an empty cache with the memory budget of rhs.
+    ArchiveCache & operator=(ArchiveCache const & rhs); /// Clears the cache and takes the memory budget of rhs.
+
+  public:
+    /// Returns the listing of an archive and marks it as the most recently used. Listings are loaded on a miss, outside of the
+    /// cache lock, and the least recently used ones are then evicted until the budget is met. The last listing is never evicted.
+    ArchivedListing::shared_listing_type listing(ArchivedListing const & archive);
+    void clear(void); /// Releases every listing of the cache.
+
+    void set_memory_budget(std::size_t bytes); /// Changes the memory budget, evicting listings if needed.
+    std::size_t memory_budget(void) const; /// Returns the memory budget, in bytes.
+    std::size_t memory_usage(void) const; /// Returns the memory used by the listings of the cache, as estimated by Listing::memory_usage.
+    std::size_t size(void) const; /// Returns the number of listings in the cache.
+    statistics_type statistics(void) const; /// Returns the hit, miss and eviction counts.
+
+  private:
+    struct entry_type
+    {
+      ArchivedListing archive; // shares the loaded listing of the archive it was asked for.
+      ArchivedListing::shared_listing_type listing;
+      std::size_t size;
+    };
+    using lru_type = std::list<entry_type>;
+
+    void evict(void); // Evicts the least recently used listings that do not fit the budget. mutex_ must be held.
+
+  private:
+    mutable std::mutex mutex_;
+    std::size_t memory_budget_;
+    std::size_t memory_usage_{ 0 };
+    lru_type entries_; // the most recently used first.
+    std::unordered_map<std::string, lru_type::iterator> index_; // entries by file name.
+    statistics_type statistics_;
+  };
+}
+
+#endif
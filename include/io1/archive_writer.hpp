@@ -0,0 +1,83 @@
+/// \file archive_writer.hpp
+#pragma once
+#ifndef IO1_ARCHIVE_WRITER_HPP
+#define IO1_ARCHIVE_WRITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <QString>
+#include <QDate>
+#include <io1/money.hpp>
+#include "io1/statement.hpp"
+#include "io1/listing_columns.hpp"
+#include "io1/archived_listing.hpp"
+#include "io1/checksum.hpp"
+
+namespace io1 {
+
+  /// Writes an archive file from statements streamed in any order, without keeping them in memory.
+  ///
+  /// Statements are formatted as they are added and buffered until the buffer exceeds the memory budget. The buffer is then
+  /// stably sorted by date and spilled into a temporary run file next to the archive. finish merges the runs into the archive
+  /// through the checksum filter, so that statements end up sorted by date, those of the same date in the order they were added.
+  /// At most max_merge_fan_in runs are open at once: when there are more, consecutive runs are first merged into longer ones.
+  /// The archive file is the one ArchivedListing writes for the same statements, and its listing can be loaded later on. Columnar
+  /// and compressed archives are written from the same runs, each statement being parsed back as it is merged.
+  class ArchiveWriter
+  {
+  public:
+    using path_type = ArchivedListing::path_type;
+    using day_type = ListingColumns::day_type;
+    using format_type = ArchivedListing::format_type;
+    static constexpr std::size_t default_memory_budget = std::size_t{ 64 } << 20;
+    static constexpr std::size_t max_merge_fan_in = 64; /// Maximum number of runs merged in a single pass, each of them holds an open file.
+
+  public:
+    /// Prepares the archive named name in filename, which must not exist and will be written in format, protected by algorithm.
+    /// Its final balance will be initial_balance plus the amounts of the statements.
+    explicit ArchiveWriter(path_type filename, QString const & name, Money initial_balance, std::size_t memory_budget = default_memory_budget, HashAlgorithm algorithm = HashAlgorithm::sha1, format_type format = format_type::text);
+    ArchiveWriter(ArchiveWriter const &) =delete;
+    ArchiveWriter & operator=(ArchiveWriter const &) =delete;
+    ~ArchiveWriter(void); /// Removes the run files.
+
+    void add(Statement const & statement); /// Adds a statement to the archive.
+    ArchivedListing finish(void); /// Writes the archive file and returns the archive, which does not hold its listing. At least one statement must have been added.
+
+    std::size_t run_count(void) const { return runs_.size(); }; /// Returns the number of runs on disk.
+
+  private:
+    struct record_type
+    {
+      day_type day; // date of the statement, as a number of days.
+      std::size_t offset; // the formatted statement spans [offset, offset+size) in buffer_.
+      std::size_t size;
+    };
+
+    void sort_buffer(void); // Stably sorts the records by date.
+    void spill(void); // Writes the sorted buffer into a new run file and clears it.
+    path_type add_run(void); // Registers a new run file, so that the destructor removes it, and returns its name.
+    template<typename SINK> void merge(std::size_t first, std::size_t last, SINK sink) const; // Merges the runs in [first, last), calling sink(day, statement) for each statement in order.
+    void merge_pass(void); // Merges the runs by groups of max_merge_fan_in into as many longer runs.
+    Checksum merge_runs(void); // Merges the run files into the archive file and returns its checksum.
+    Checksum write_buffer(void); // Writes the sorted buffer into the archive file and returns its checksum.
+
+  private:
+    path_type filename_;
+    std::string name_;
+    std::string header_; // formatted name of the listing, written before the statements of text archives.
+    Money final_balance_;
+    day_type final_day_{ 0 };
+    QDate final_date_; // date of the latest statement, which is final_day_.
+    std::size_t memory_budget_;
+    HashAlgorithm algorithm_;
+    format_type format_;
+    std::size_t count_{ 0 };
+    std::string buffer_; // formatted statements not spilled yet.
+    std::vector<record_type> records_;
+    std::vector<path_type> runs_; // the runs on disk, in the order their statements were added.
+    std::size_t run_names_{ 0 }; // number of run files created so far, which numbers the next one.
+  };
+}
+
+#endif
@@ -4,38 +4,86 @@
 #define IO1_ARCHIVED_LISTING_HPP
 
 #include "io1/listing.hpp"
-#include <boost/optional.hpp>
+#include "io1/checksum.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 
 namespace io1 {
 
+  /// A listing stored in a file, which is only read when its statements are needed.
+  ///
+  /// Copies of an archive share its loaded listing. Listings are loaded through an ArchiveCache, which bounds the memory they use.
   class ArchivedListing
   {
   public:
     using listing_type = Listing<non_committable_tag>;
+    using shared_listing_type = std::shared_ptr<listing_type const>;
     using path_type = boost::filesystem::path;
 
-  private:
-    using optional_listing_type = boost::optional<listing_type>;
+    /// When the SHA-1 of the file is checked against the recorded one.
+    enum class verification_type
+    {
+      immediate, /// the file is hashed on construction.
+      deferred, /// the file is hashed when its listing is read, or when verify is called.
+    };
+
+    /// How the listing is stored in the file. Reading detects the format of the file.
+    enum class format_type
+    {
+      text, /// as Listing::write writes it.
+      columnar, /// in binary column blocks, see ColumnarArchiveWriter. Loads without parsing and reads date ranges block by block.
+      compressed, /// in compressed column blocks, a fraction of the size of a text file, read like columnar ones.
+    };
 
   public:
     ArchivedListing(void) =default;
-    explicit ArchivedListing(path_type filename, QDate final_date, Money final_balance, std::string sha1);
-    explicit ArchivedListing(path_type filename, listing_type listing, QDate final_date, Money final_balance);
+    explicit ArchivedListing(path_type filename, QDate final_date, Money final_balance, Checksum checksum, verification_type verification = verification_type::immediate);
+    explicit ArchivedListing(path_type filename, listing_type listing, QDate final_date, Money final_balance, HashAlgorithm algorithm = HashAlgorithm::sha1, format_type format = format_type::text); /// Writes the listing into filename in format, protected by algorithm.
+
+    bool is_loaded(void) const; /// Returns true if the listing is in memory.
+    void release_listing(void) const; /// Drops the listing, which is read again from the file when next asked for.
+    void verify(void) const; /// Hashes the file and throws Sha1Mismatch if it does not match the recorded checksum. May be called from several threads at once.
+
+    /// Returns the statements dated within [from, to], sorted by date. A loaded listing answers from memory. Otherwise a columnar
+    /// or compressed file only has the blocks that overlap the range read, each checked against its own checksum, and a text file
+    /// is read without keeping its listing.
+    std::vector<Statement> statements_between(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const;
 
-    listing_type const & listing(void) const;
+    path_type const & filename(void) const { return filename_; }; /// Returns the name of the file that holds the listing.
     Money final_balance(void) const { return final_balance_; };
+    Checksum const & checksum(void) const { return checksum_; }; /// Returns the checksum of the file, and the algorithm that computed it.
 
   public:
     std::ostream & write(std::ostream & stream) const;
-    static ArchivedListing read(std::istream & stream);
+    static ArchivedListing read(std::istream & stream, verification_type verification = verification_type::immediate);
 
   private:
-    mutable optional_listing_type listing_;
+    friend class ArchiveWriter; // which writes the file itself.
+    friend class Account; // which hands over the statements it just archived.
+    friend class ArchiveCache; // through which listings are loaded.
+
+    // Returns the listing, which is read from the file on first call. Concurrent calls read it once and share it. The listing lives
+    // as long as the returned pointer, even if the archive releases it meanwhile. Its caches are built before it is shared, see Listing::build_caches.
+    shared_listing_type listing(void) const;
+    void hold_listing(listing_type listing) const; // Keeps listing in memory as if it had been read from the file, which must hold the same statements in the same order.
+
+    listing_type read_listing(void) const; // Reads and checks the listing from the file.
+    shared_listing_type share(listing_type listing) const; // Builds the caches of listing, which is only read from then on, and shares it.
+
+    struct load_state_type
+    {
+      std::mutex mutex; // held while the listing is read.
+      shared_listing_type listing;
+    };
+
+    std::shared_ptr<load_state_type> load_state_{ std::make_shared<load_state_type>() }; // shared by copies, which therefore load the listing once.
     Money final_balance_;
     QDate final_date_;
     path_type filename_;
-    std::string sha1_;
+    Checksum checksum_;
   };
 
   std::ostream & operator<<(std::ostream & stream, ArchivedListing const & archive);
@@ -0,0 +1,77 @@
+/// \file block_checksums.hpp
+#pragma once
+#ifndef IO1_BLOCK_CHECKSUMS_HPP
+#define IO1_BLOCK_CHECKSUMS_HPP
+
+#include <cstddef>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/exception/error_info.hpp>
+#include "io1/checksum.hpp"
+
+namespace io1 {
+
+  /// Checksums of a listing file cut into blocks of a fixed number of statements, and a root checksum over them.
+  ///
+  /// The listing file is left as Listing::write writes it, the first block also holds its title. The checksums are written in a
+  /// small index file, whose own checksum is the root: an edit then only rehashes the blocks it changed, and a corrupted listing
+  /// file is reported along with the block at fault.
+  class BlockChecksums
+  {
+  public:
+    static constexpr std::size_t default_block_size = 4096; /// Statements per block.
+
+    struct block_type
+    {
+      std::size_t statement_count{ 0 };
+      std::size_t byte_count{ 0 };
+      Checksum checksum; /// Has an empty digest while the block is stale.
+
+      bool operator==(block_type const & rhs) const =default;
+    };
+
+    using errinfo_block_index = boost::error_info<struct tag_block_index, std::size_t>; /// Index of the block that failed verification.
+
+  public:
+    BlockChecksums(void) =default;
+    explicit BlockChecksums(HashAlgorithm algorithm, std::size_t block_size = default_block_size);
+
+    HashAlgorithm algorithm(void) const { return algorithm_; };
+    std::size_t block_size(void) const { return block_size_; };
+    std::vector<block_type> const & blocks(void) const { return blocks_; };
+    std::size_t first_statement(std::size_t block) const { return block * block_size_; }; /// Returns the position of the first statement of a block.
+
+    /// Returns the checksum of the index as write writes it, which covers every block. No block may be stale.
+    Checksum root(void) const;
+
+  public:
+    /// Marks the blocks of the statements in [first, last) as stale. Statements from first on are dropped when last is left
+    /// out, for edits that shift the statements that follow them.
+    void invalidate(std::size_t first, std::size_t last = std::numeric_limits<std::size_t>::max());
+    void resize(std::size_t statement_count); /// Adjusts the blocks to a listing of statement_count statements, blocks whose statement count changes become stale.
+    bool is_stale(std::size_t block) const { return blocks_[block].checksum.digest().empty(); };
+    bool is_up_to_date(std::size_t statement_count) const; /// Returns true if the blocks match a listing of statement_count statements and none of them is stale.
+    void set_block(std::size_t block, std::string_view bytes); /// Hashes the bytes of a block, as they are written in the listing file.
+
+    /// Hashes each block of a listing file and throws Sha1Mismatch, with the index of the first block that does not match.
+    void verify(std::string_view bytes) const;
+
+  public:
+    std::ostream & write(std::ostream & stream) const;
+    static BlockChecksums read(std::istream & stream); /// Throws ParseError if the stream does not hold an index.
+    bool operator==(BlockChecksums const & rhs) const =default;
+
+  private:
+    HashAlgorithm algorithm_{ HashAlgorithm::sha1 };
+    std::size_t block_size_{ default_block_size };
+    std::vector<block_type> blocks_;
+  };
+
+  std::ostream & operator<<(std::ostream & stream, BlockChecksums const & checksums);
+  std::istream & operator>>(std::istream & stream, BlockChecksums & checksums);
+}
+
+#endif
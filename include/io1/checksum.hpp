@@ -0,0 +1,129 @@
+/// \file checksum.hpp
+#pragma once
+#ifndef IO1_CHECKSUM_HPP
+#define IO1_CHECKSUM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/operations.hpp>
+
+namespace io1 {
+
+  /// Hash algorithms that protect the files of an account.
+  enum class HashAlgorithm
+  {
+    sha1, /// cryptographic, uses the SHA instructions of the CPU when it has them.
+    xxh64, /// non cryptographic and much faster, catches accidental corruption only.
+  };
+
+  /// A digest along with the algorithm that computed it, written as "<algorithm>:<hexadecimal digest>".
+  ///
+  /// Files written before the algorithm was recorded hold a bare SHA-1 digest, which is still read.
+  class Checksum
+  {
+  public:
+    Checksum(void) =default;
+    explicit Checksum(HashAlgorithm algorithm, std::string digest); /// digest is the lowercase hexadecimal digest.
+
+    HashAlgorithm algorithm(void) const { return algorithm_; };
+    std::string const & digest(void) const { return digest_; };
+    std::string to_string(void) const; /// Returns the checksum as it is written in files.
+
+    bool operator==(Checksum const & rhs) const =default;
+
+  public:
+    /// Parses a checksum written by to_string, or a bare SHA-1 digest. Returns false if text is not a checksum.
+    [[nodiscard]] static bool parse(std::string_view text, Checksum & checksum) noexcept;
+
+  private:
+    HashAlgorithm algorithm_{ HashAlgorithm::sha1 };
+    std::string digest_;
+  };
+
+  std::ostream & operator<<(std::ostream & stream, Checksum const & checksum);
+  std::istream & operator>>(std::istream & stream, Checksum & checksum); /// Throws ParseError if the next word is not a checksum.
+
+  std::string_view to_string(HashAlgorithm algorithm); /// Returns the name of the algorithm, as written in checksums.
+
+  namespace detail
+  {
+    struct sha1_state
+    {
+      std::array<std::uint32_t, 5> h{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+      std::array<unsigned char, 64> block; // bytes not hashed yet, there are length % 64 of them.
+      std::uint64_t length{ 0 };
+    };
+
+    struct xxh64_state
+    {
+      std::array<std::uint64_t, 4> v{ 0x60EA27EEADC0B5D6, 0xC2B2AE3D27D4EB4F, 0, 0x61C8864E7A143579 }; // accumulators for a null seed.
+      std::array<unsigned char, 32> stripe; // bytes not hashed yet, there are length % 32 of them.
+      std::uint64_t length{ 0 };
+    };
+  }
+
+  /// Incrementally hashes bytes with one of the algorithms.
+  class Hasher
+  {
+  public:
+    explicit Hasher(HashAlgorithm algorithm = HashAlgorithm::sha1);
+
+    HashAlgorithm algorithm(void) const;
+    Hasher & update(std::string_view bytes); /// Hashes the next bytes.
+    Checksum checksum(void) const; /// Returns the checksum of the bytes hashed so far, more bytes can be hashed afterwards.
+
+  private:
+    std::variant<detail::sha1_state, detail::xxh64_state> state_;
+  };
+
+  Checksum checksum(HashAlgorithm algorithm, std::string_view bytes); /// Returns the checksum of a buffer.
+  Checksum file_checksum(HashAlgorithm algorithm, boost::filesystem::path const & filename); /// Returns the checksum of a file, which is mapped in memory.
+
+  /// Returns true when SHA-1 runs on the SHA instructions of the CPU (SHA-NI on x86, the cryptographic extension on ARMv8).
+  bool sha1_acceleration(void);
+  /// Turns the SHA instructions off, or back on when the CPU has them. Meant for tests and benchmarks, not thread safe.
+  void set_sha1_acceleration(bool enabled);
+
+  /// Boost.Iostreams filter that hashes the characters going through it, in either direction.
+  ///
+  /// Chains keep a copy of the filters pushed into them: copies share their hash, so the checksum is read from the filter that was pushed.
+  class ChecksumFilter
+  {
+  public:
+    using char_type = char;
+    struct category : boost::iostreams::dual_use, boost::iostreams::filter_tag, boost::iostreams::multichar_tag, boost::iostreams::closable_tag {};
+
+  public:
+    explicit ChecksumFilter(HashAlgorithm algorithm = HashAlgorithm::sha1) :hasher_(std::make_shared<Hasher>(algorithm)) {};
+
+    Checksum checksum(void) const { return hasher_->checksum(); }; /// Returns the checksum of what went through the filter so far.
+
+    template<typename SOURCE> std::streamsize read(SOURCE & source, char * s, std::streamsize n)
+    {
+      auto const count = boost::iostreams::read(source, s, n);
+      if (0 < count) hasher_->update({ s, static_cast<std::size_t>(count) });
+      return count;
+    };
+
+    template<typename SINK> std::streamsize write(SINK & sink, char const * s, std::streamsize n)
+    {
+      hasher_->update({ s, static_cast<std::size_t>(n) });
+      return boost::iostreams::write(sink, s, n);
+    };
+
+    template<typename DEVICE> void close(DEVICE &, std::ios_base::openmode) {};
+
+  private:
+    std::shared_ptr<Hasher> hasher_;
+  };
+}
+
+#endif
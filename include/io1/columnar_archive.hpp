@@ -0,0 +1,125 @@
+/// \file columnar_archive.hpp
+#pragma once
+#ifndef IO1_COLUMNAR_ARCHIVE_HPP
+#define IO1_COLUMNAR_ARCHIVE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "io1/listing.hpp"
+#include "io1/listing_columns.hpp"
+#include "io1/checksum.hpp"
+
+namespace io1 {
+
+  /// Writes a listing in the binary columnar format, an alternative to the text Listing::write writes for archives, which never change.
+  ///
+  /// Statements are stored in blocks of columns: the day number and the amount in cents of each entry as fixed width little
+  /// endian integers, the entry count of each statement, and the descriptions in a string blob. A footer at the end of the file
+  /// gives the offset, the statement count, the earliest and latest days and the checksum of each block. The file starts and ends
+  /// with a magic number, which text listings cannot start with, and whose last byte tells how the blocks are encoded.
+  ///
+  /// Compressed blocks trade the fixed width columns for a single pass of variable length integers: each block starts with the
+  /// dictionary of its distinct descriptions, then each statement gives its entry count and each entry the change of its day
+  /// from the previous entry, its zig-zag encoded amount and the index of its description.
+  class ColumnarArchiveWriter
+  {
+  public:
+    static constexpr std::size_t default_block_size = 4096; /// Statements per block.
+
+    enum class encoding_type
+    {
+      fixed, /// fixed width little endian columns.
+      compressed, /// variable length integers, delta encoded days and dictionary coded descriptions.
+    };
+
+  public:
+    /// Starts writing a listing named name into stream, blocks are protected by algorithm and encoded with encoding.
+    explicit ColumnarArchiveWriter(std::ostream & stream, std::string name, HashAlgorithm algorithm = HashAlgorithm::sha1, std::size_t block_size = default_block_size, encoding_type encoding = encoding_type::fixed);
+    ColumnarArchiveWriter(ColumnarArchiveWriter const &) =delete;
+    ColumnarArchiveWriter & operator=(ColumnarArchiveWriter const &) =delete;
+
+    void add(Statement const & statement); /// Adds the next statement, statements are expected in date order for date ranges to skip blocks.
+    void finish(void); /// Writes the last block and the footer.
+
+  private:
+    void write_block(void);
+    void encode_fixed(std::string & block) const;
+    void encode_compressed(std::string & block) const;
+
+  private:
+    std::ostream & stream_;
+    std::string name_;
+    HashAlgorithm algorithm_;
+    std::size_t block_size_;
+    encoding_type encoding_;
+    std::uint64_t offset_{ 0 }; // bytes written so far.
+    std::uint64_t block_count_{ 0 };
+    std::string footer_; // descriptors of the blocks written so far.
+
+    // columns of the block being filled.
+    std::vector<std::int64_t> amounts_;
+    std::vector<ListingColumns::day_type> days_;
+    std::vector<std::uint32_t> entry_counts_;
+    std::vector<std::uint32_t> description_ends_;
+    std::string descriptions_;
+  };
+
+  /// Reads a listing written in the binary columnar format from memory, usually a mapped file.
+  ///
+  /// Only the footer is read on construction. Blocks are decoded from their columns without parsing any text, and a date range
+  /// only decodes the blocks whose days overlap it. Compressed blocks are decoded in a single pass over their bytes, straight
+  /// into statements.
+  class ColumnarArchive
+  {
+  public:
+    using listing_type = Listing<non_committable_tag>;
+    using day_type = ListingColumns::day_type;
+    using encoding_type = ColumnarArchiveWriter::encoding_type;
+
+    struct block_type
+    {
+      std::uint64_t offset;
+      std::uint64_t size;
+      std::uint32_t statement_count;
+      std::uint32_t entry_count;
+      day_type first_day; /// Earliest date of the statements of the block, as a day number.
+      day_type last_day; /// Latest date of the statements of the block, as a day number.
+      Checksum checksum;
+    };
+
+  public:
+    /// Reads the footer of a file held by bytes, which must outlive the archive. Throws CorruptedFile if it is damaged.
+    explicit ColumnarArchive(std::string_view bytes);
+
+    std::string const & name(void) const { return name_; };
+    encoding_type encoding(void) const { return encoding_; };
+    std::vector<block_type> const & blocks(void) const { return blocks_; };
+    std::size_t size(void) const; /// Returns the number of statements.
+
+    /// Returns the whole listing. Blocks are not checked against their checksums, since the whole file is usually checked beforehand.
+    listing_type listing(void) const;
+    /// Appends the statements of a block to statements, once the block is checked. Throws Sha1Mismatch with BlockChecksums::errinfo_block_index if it is damaged.
+    void read_block(std::size_t block, std::vector<Statement> & statements) const;
+    /// Returns the statements dated within [from, to], in file order. Only the blocks whose days overlap the range are read and checked.
+    std::vector<Statement> statements_between(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const;
+
+  public:
+    static bool is_columnar(std::string_view bytes); /// Returns true if bytes start with the magic number of the format, whatever the encoding.
+
+  private:
+    void decode_block(std::size_t block, std::vector<Statement> & statements) const; // Throws CorruptedFile if the columns are inconsistent.
+
+  private:
+    std::string_view bytes_;
+    encoding_type encoding_{ encoding_type::fixed };
+    std::string name_;
+    std::vector<block_type> blocks_;
+  };
+}
+
+#endif
@@ -2,7 +2,10 @@
 
 #include <io1/money.hpp>
 #include <chrono>
+#include <format>
 #include <string>
+#include <string_view>
+#include <cstddef>
 #include <iosfwd>
 
 namespace io1
@@ -27,7 +30,9 @@ namespace io1
 
   public:
     std::ostream & write(std::ostream & stream) const; /// Formats the entry into a std::ostream using UTF8. It can be re-read with the read function.
+    template<typename OUT> OUT format_to(OUT out) const { return std::format_to(std::move(out), "{:<10}{:<10}{}\n", date_, amount_.data(), description_); }; /// Formats the entry into an output iterator using UTF8, as write does.
     static Entry read(std::istream & stream); /// Reads an entry from a UTF8 std::istream.
+    static std::size_t read(std::string_view buffer, Entry & entry); /// Reads an entry from the beginning of a UTF8 buffer and returns the number of bytes consumed. Only the description may allocate.
     bool equals(Entry const & rhs) const; /// Returns true if rhs equals the object.
 
   private:
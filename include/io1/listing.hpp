@@ -3,16 +3,112 @@
 #ifndef IO1_LISTING_HPP
 #define IO1_LISTING_HPP
 
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <string_view>
+#include <variant>
 #include <vector>
+#include <format>
 #include <boost/range/istream_range.hpp>
 #include <boost/container/flat_set.hpp>
+#include <boost/optional.hpp>
+#include <boost/iterator/permutation_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
 #include <QString>
 #include "io1/statement.hpp"
+#include "io1/listing_columns.hpp"
+#include "io1/selection_bitmap.hpp"
+#include "io1/block_checksums.hpp"
 
 namespace io1
 {
   struct committable_tag;
   struct non_committable_tag;
+  template<typename COMMITTABLE> class Listing;
+
+  /// A reference to a statement of a listing that stays valid when other statements are added, removed or moved.
+  ///
+  /// Handles are obtained from Listing::handle and resolved in constant time by Listing::resolve. A handle becomes stale when
+  /// its statement is erased or grouped, stale handles resolve to the end of the listing. Handles are ordered so that they can be
+  /// stored in sets, the order has nothing to do with the order of the statements.
+  class StatementHandle
+  {
+  public:
+    StatementHandle(void) =default; /// Creates a handle that designates no statement.
+    auto operator<=>(StatementHandle const &) const =default;
+
+  private:
+    template<typename COMMITTABLE> friend class Listing;
+    StatementHandle(std::uint32_t slot, std::uint32_t generation) :slot_(slot), generation_(generation) {};
+
+  private:
+    std::uint32_t slot_{ std::numeric_limits<std::uint32_t>::max() };
+    std::uint32_t generation_{ 0 };
+  };
+
+  /// A statement of a committable listing, whose commit state is read and changed through the listing.
+  ///
+  /// It is what dereferencing an iterator of a committable listing yields. It converts to Statement const & and forwards its
+  /// accessors, so that it can be used in place of the statement. Like the listing iterators, it is only valid until the listing is edited.
+  class CommittableStatementReference
+  {
+  public:
+    explicit CommittableStatementReference(Statement const & statement, Listing<committable_tag> const & listing, std::size_t position) :statement_(&statement), listing_(&listing), position_(position) {};
+    operator Statement const & (void) const { return *statement_; }; /// Returns the statement itself.
+
+    bool is_committed(void) const; /// Returns the commit state of the statement, see Listing::is_committed.
+    void set_committed(bool committed = true) const; /// Changes the commit state of the statement, see Listing::set_committed.
+
+  public:
+    QDate date(void) const { return statement_->main_entry().date(); }; // by value, as the entry holds them in other types.
+    QString description(void) const { return statement_->main_entry().description(); };
+    Money amount(void) const { return statement_->amount(); };
+    Entry const & main_entry(void) const { return statement_->main_entry(); };
+    Statement::const_range composed_entries(void) const { return statement_->composed_entries(); };
+    bool is_composed(void) const { return statement_->is_composed(); };
+    std::size_t entry_count(void) const { return statement_->entry_count(); };
+    std::ostream & write(std::ostream & stream) const; /// Writes the statement and its commit state, as CommittableStatement does.
+    template<typename OUT> OUT format_to(OUT out) const { return CommittableStatement::format_to(std::move(out), *statement_, is_committed()); }; /// Same as above, into an output iterator.
+    bool equals(Statement const & rhs) const { return statement_->equals(rhs); };
+
+  private:
+    Statement const * statement_;
+    Listing<committable_tag> const * listing_;
+    std::size_t position_;
+  };
+
+  /// The iterator of a committable listing, which yields CommittableStatementReference.
+  class CommittableStatementIterator: public boost::iterator_facade<CommittableStatementIterator, Statement const, std::random_access_iterator_tag, CommittableStatementReference>
+  {
+  public:
+    using base_type = std::vector<Statement>::const_iterator;
+
+  public:
+    CommittableStatementIterator(void) =default;
+    explicit CommittableStatementIterator(base_type statement, Listing<committable_tag> const & listing) :statement_(statement), listing_(&listing) {};
+
+    base_type base(void) const { return statement_; }; /// Returns the iterator of the statement in the storage of the listing.
+    CommittableStatementReference operator[](std::ptrdiff_t n) const { return *(*this + n); };
+
+  private:
+    friend class boost::iterator_core_access;
+
+    CommittableStatementReference dereference(void) const;
+    bool equal(CommittableStatementIterator const & rhs) const { return statement_ == rhs.statement_; };
+    void increment(void) { ++statement_; };
+    void decrement(void) { --statement_; };
+    void advance(std::ptrdiff_t n) { statement_ += n; };
+    std::ptrdiff_t distance_to(CommittableStatementIterator const & rhs) const { return rhs.statement_ - statement_; };
+
+  private:
+    base_type statement_;
+    Listing<committable_tag> const * listing_{ nullptr };
+  };
   
   /// A class that models a bank account listing.
   ///
@@ -21,82 +117,372 @@ namespace io1
   {
   public:
     using statement_type = typename COMMITTABLE::statement_type;
+    static constexpr bool is_committable = std::is_same_v<COMMITTABLE, committable_tag>;
 
   private:
     using vector_type = std::vector<statement_type>;
+    using vector_iterator = typename vector_type::const_iterator;
 
   public:
-    using const_iterator = typename vector_type::const_iterator;
+    /// The statements of a committable listing are yielded as CommittableStatementReference, which give access to their commit state.
+    using const_iterator = std::conditional_t<is_committable, CommittableStatementIterator, vector_iterator>;
     using const_range = boost::iterator_range<const_iterator>;
     using statement_selection = boost::container::flat_set<const_iterator>;
+    using handle_selection = boost::container::flat_set<StatementHandle>;
+    using date_index_type = std::vector<std::uint32_t>;
+    using date_range = boost::iterator_range<boost::permutation_iterator<const_iterator, date_index_type::const_iterator>>;
+
+    class Transaction;
 
   public:
     Listing(void) =default;
     explicit Listing(QString name);
+    /// Creates a listing out of a range of statements. Committable statements keep their commit state in a committable listing.
     template<class RANGE> explicit Listing(QString name, RANGE const & range)
-    :name_(std::move(name)),statements_(range.begin(),range.end())
-    {};
+    :name_(std::move(name)),statements_(range.begin(),range.end()),commit_states_(statements_.size())
+    {
+      std::size_t position = 0;
+      for (auto const & statement : range)
+      {
+        if constexpr (is_committable && requires { statement.is_committed(); }) commit_states_.assign(position, statement.is_committed());
+        ++position;
+      }
+      for (auto const & statement : statements_) total_amount_ += statement.amount();
+      sorted_size_ = sorted_prefix_size();
+    };
 
   public:
     /// Adds a statement to the listing. Arguments are forwarded to the Statement constructor.
     template <class... ARGS> const_iterator add_statement(ARGS && ... args)
     {
-      return statements_.emplace(statements_.end(),std::forward<ARGS>(args)...);
+      auto const statement = statements_.emplace(statements_.end(),std::forward<ARGS>(args)...);
+      total_amount_ += statement->amount();
+      commit_states_.push_back(false);
+      if (sorted_size_ + 1 == statements_.size() && (1 == statements_.size() || !(statement->date() < (statement - 1)->date()))) ++sorted_size_;
+      if (has_handles()) position_slots_.push_back(no_slot);
+      if (journaling()) journal_replacement(statements_.size() - 1, 1, {});
+      if (columns_) columns_->push_back(*statement);
+      if (date_index_) append_to_date_index(to_iterator(statement));
+      check_total_amount();
+
+      return to_iterator(statement);
     };
 
-    void sort(void);
-    void stable_sort(void);
+    /// Sorts the statements by date. Only the statements that follow the sorted prefix are sorted and then merged into it,
+    /// so that sorting after appending a few statements to a sorted listing is close to linear.
+    /// Large listings are sorted on up to thread_count threads, pass std::thread::hardware_concurrency() to use every core.
+    void sort(unsigned thread_count = 1);
+    void stable_sort(unsigned thread_count = 1); /// Same as sort, but statements of the same date keep their relative order.
+    bool is_sorted(void) const { return statements_.size() == sorted_size_; }; /// Returns true if the statements are sorted by date.
     const_iterator erase_statement(const_iterator position);
     const_iterator group_range(QString description, QDate date, const_range statements);
+    /// Moves the selected statements next to the last one of them, keeping their order, and returns the range they span.
+    /// Runs in linear time in the distance between the first and the last selected statements.
     const_range gather_selection(statement_selection const & selected_statements);
+    const_range gather_selection(handle_selection const & selected_statements); /// Same as above, stale handles are ignored.
+    const_range gather_selection(SelectionBitmap const & selected_statements); /// Same as above, the bitmap must be sized for the listing.
     const_range split_statement(const_iterator statement);
     void swap_statements(const_iterator position1, const_iterator position2);
     void move_statement_down(const_iterator statement, const_iterator position);
     void move_statement_up(const_iterator statement, const_iterator position);
     void move_statement(const_iterator statement, const_iterator position);
 
-    /// Changes the designated statement for the one constructed from the remaining arguments.
+    /// Changes the designated statement for the one constructed from the remaining arguments, which may refer to the designated statement.
+    /// The listing is left unchanged if the construction throws.
     template <class... ARGS> void alter_statement(const_iterator position, ARGS && ... args)
     {
-      // const_casting is faster than doing statements_.emplace(statements_.erase(position),std::forward<ARGS>(args)...).
-      auto & statement_ref = const_cast<statement_type &>(*position);
-      statement_ref = statement_type(std::forward<ARGS>(args)...);
+      // the replacement is built before anything changes, then swapped in, which leaves the altered statement to the journal.
+      statement_type replacement(std::forward<ARGS>(args)...);
+      auto const index = static_cast<std::size_t>(position - begin());
+      auto & statement_ref = *remove_const(position);
+      std::swap(statement_ref, replacement);
+
+      total_amount_ -= replacement.amount();
+      total_amount_ += statement_ref.amount();
+      truncate_sorted_prefix(position);
+      reset_caches(index, index + 1);
+      if (journaling()) journal_replacement(index, 1, vector_type(std::make_move_iterator(&replacement), std::make_move_iterator(&replacement + 1)));
+      commit_states_.reset(index); // an altered statement is no longer committed.
+      check_total_amount();
 
       return;
     };
 
+  public:
+    /// The listing holds the commit state of its statements, one bit per statement, which edits move along with the statements.
+    /// Added, altered, grouped and split statements are not committed.
+    bool is_committed(const_iterator statement) const requires is_committable { return commit_states_.test(statement - begin()); }; /// Returns the commit state of a statement.
+    void set_committed(const_iterator statement, bool committed = true) requires is_committable; /// Changes the commit state of a statement, along with its column and the checksum of its block.
+
+    /// Returns a bitmap of the committed statements, for counts and scans that go through 64 statements at a time.
+    SelectionBitmap const & committed_statements(void) const requires is_committable { return commit_states_; };
+    SelectionBitmap uncommitted_statements(void) const requires is_committable; /// Returns a bitmap of the statements that are not committed.
+    std::size_t committed_count(void) const requires is_committable { return committed_statements().count(); }; /// Returns the number of committed statements.
+
+    /// Moves the committed statements out into a new listing named name, in a single pass that keeps their order and compacts
+    /// the remaining statements in place. No statement is copied. Handles of the moved statements become stale and the journal is cleared.
+    Listing<non_committable_tag> extract_committed(QString name) requires is_committable;
+    Money erase_committed(void) requires is_committable; /// Same as above, but the committed statements are destroyed. Returns their total amount.
+
+  public:
+    /// The journal records the inverse of each edit so that it can be undone, and then redone.
+    ///
+    /// It only stores the statements an edit removes or replaces, undoing and redoing an edit therefore cost as much as the edit.
+    /// Adding, erasing, altering, grouping, splitting, swapping and moving statements are journaled. Sorts, gathering a selection and
+    /// committing a transaction move too many statements to be worth journaling, they clear the journal. Editing after an undo
+    /// clears the edits that could be redone. The journal is disabled until a limit is set.
+    void set_journal_limit(std::size_t bytes); /// Sets the approximate memory the journal may use, oldest edits are forgotten first. Zero disables the journal.
+    std::size_t journal_limit(void) const { return journal_limit_; };
+    std::size_t journal_size(void) const { return journal_size_; }; /// Returns the approximate memory used by the journal.
+    bool can_undo(void) const { return !undo_records_.empty(); };
+    bool can_redo(void) const { return !redo_records_.empty(); };
+    bool undo(void); /// Undoes the last edit. Returns false if there is nothing to undo.
+    bool redo(void); /// Redoes the last undone edit. Returns false if there is nothing to redo.
+    void clear_journal(void); /// Forgets every edit.
+
+  public:
+    /// Returns a transaction that records edits of this listing and applies them all at once when committed.
+    Transaction transaction(void) { return Transaction(*this); };
+
+  public:
+    /// Returns a handle to a statement. It keeps designating the statement whatever is done to the others, including sorts.
+    /// The statement keeps its handle when it is altered or split, in which case the handle designates the first entry.
+    /// The handle becomes stale when the statement is erased, grouped or released. Undoing the erase or the grouping makes it valid again,
+    /// as long as the journal still holds the edit.
+    StatementHandle handle(const_iterator statement);
+    const_iterator resolve(StatementHandle handle) const; /// Returns the statement designated by a handle in constant time, or end() if the handle is stale.
+    statement_selection resolve(handle_selection const & handles) const; /// Returns the statements designated by the handles that are not stale.
+
+    /// Returns a bitmap that selects the statements for which predicate(statement) is true.
+    template<typename PREDICATE> SelectionBitmap select_if(PREDICATE predicate) const
+    {
+      SelectionBitmap selection(statements_.size());
+      for (std::size_t position = 0; statements_.size() > position; ++position)
+        if (predicate(statements_[position])) selection.set(position);
+
+      return selection;
+    };
+    void release_handle(StatementHandle handle); /// Makes a handle stale so that its slot can be reused.
+
   public:
     QString const & name(void) const { return name_; }; /// Returns the name of the listing.
-    void set_name (QString const & name) { name_ = name; }; /// Changes the name of the listing.
+    void set_name (QString const & name) { name_ = name; if (block_checksums_) block_checksums_->invalidate(0, 1); }; /// Changes the name of the listing.
+    Money total_amount(void) const { return total_amount_; }; /// Returns the sum of the amounts of all statements, in constant time.
+    std::size_t memory_usage(void) const; /// Returns an estimate of the memory held by the statements, in bytes. Runs in linear time.
 
   public:
-    const_range statements(void) const { return statements_; };
-    const_iterator begin(void) const { return statements_.begin(); };
-    const_iterator end(void) const { return statements_.end(); };
+    const_range statements(void) const { return const_range(begin(), end()); };
+    const_iterator begin(void) const { return to_iterator(statements_.begin()); };
+    const_iterator end(void) const { return to_iterator(statements_.end()); };
+
+    /// Returns a columnar view of the statements. It is built on first call and then kept up to date by the listing.
+    ListingColumns const & columns(void) const;
+
+    /// Returns the statements dated within [from, to], sorted by date, in O(log n + k).
+    /// The date index is built on first call. Adding, erasing, moving and swapping statements update it, statements added out of
+    /// date order being merged in by the next call. It is rebuilt after any other mutation.
+    date_range statements_between(QDate const & from, QDate const & to) const;
+
+    /// Returns the checksums of the listing as write writes it, in blocks of block_size statements. They are computed on first call,
+    /// then only the blocks that edits changed are rehashed: altering or committing a statement, or adding one, costs a block
+    /// whatever the size of the listing. Other edits rehash every block from the first statement they move.
+    BlockChecksums const & block_checksums(HashAlgorithm algorithm, std::size_t block_size = BlockChecksums::default_block_size) const;
+    void adopt_block_checksums(BlockChecksums checksums); /// Takes checksums known to match the listing, such as the ones it was verified against when read.
+
+    /// Builds the columns, the date index and the block checksums of algorithm with the default block size. Until the next edit,
+    /// columns, statements_between and block_checksums with the same arguments then only read the listing, which may therefore be
+    /// shared between threads. The other const methods never write to the listing.
+    void build_caches(HashAlgorithm algorithm) const;
 
   public:
     std::ostream & write(std::ostream & stream) const;
+
+    /// Formats the listing into an output iterator using UTF8. Formatting into a single buffer is much faster than writing statements one by one.
+    template<typename OUT> OUT format_to(OUT out) const
+    {
+      out = format_title_to(std::move(out));
+      return format_statements_to(std::move(out), 0, statements_.size());
+    };
+
     static Listing read(std::istream & stream);
+    static Listing read(std::string_view buffer); /// Reads a listing from a UTF8 buffer holding what write writes. Parses statements in place, without any stream.
     bool equals(Listing const & rhs) const;
     bool empty(void) const { return statements_.empty(); };
 
   private:
+    template<typename OTHER> friend class Listing; // extract_committed builds the listing of another tag.
+    explicit Listing(QString name, vector_type statements, Money total_amount, std::size_t sorted_size); // Takes statements whose total and sorted prefix are already known.
     typename vector_type::iterator remove_const (const_iterator statement);
+    const_iterator to_iterator(vector_iterator statement) const { if constexpr (is_committable) return const_iterator(statement, *this); else return statement; }; // Wraps an iterator of statements_.
+    static vector_iterator to_vector_iterator(const_iterator statement) { if constexpr (is_committable) return statement.base(); else return statement; }; // Unwraps an iterator of the listing.
+    template<typename SORT> void sort_impl(SORT sort_tail); // Sorts statements with sort_tail(first, last, compare).
+    template<typename SINK> Money remove_committed(SINK sink); // Moves each committed statement into sink(statement) and returns their total amount.
+    std::vector<Entry> combine_entries(const_range statements); // Moves out the entries of a range of statements, as grouped by group_range.
+    template<typename IS_SELECTED> const_range gather_window(std::size_t first, std::size_t last, std::size_t count, IS_SELECTED is_selected); // is_selected is called once per position, in increasing order.
+    // Must be called by every mutation but the ones that update the caches, with the positions it changed. When last is left out,
+    // every statement from first on may have moved.
+    void reset_caches(std::size_t first = 0, std::size_t last = std::numeric_limits<std::size_t>::max());
+    void invalidate_statements(std::size_t first = 0, std::size_t last = std::numeric_limits<std::size_t>::max()); // Same as reset_caches, for the mutations that update the date index themselves.
+    template<typename OUT> OUT format_title_to(OUT out) const { return std::format_to(std::move(out), "\n{}\n\n", name_.toStdString()); };
+    template<typename OUT> OUT format_statements_to(OUT out, std::size_t first, std::size_t last) const // Formats the statements in [first, last) along with their commit state.
+    {
+      for (auto position = first; last > position; ++position)
+      {
+        if constexpr (is_committable) out = CommittableStatement::format_to(std::move(out), statements_[position], commit_states_.test(position));
+        else out = statements_[position].format_to(std::move(out));
+      }
+
+      return out;
+    };
+    void append_to_date_index(const_iterator statement); // Adds an appended statement to the date index, in constant time.
+    date_index_type const & date_index(void) const; // Builds the date index on first call, and merges the statements appended out of date order into it.
+    void merge_date_index(void) const; // Merges the statements appended out of date order into the date index.
+    date_index_type::iterator find_in_date_index(std::size_t position) const; // Returns where the statement at position is, or belongs, in the merged date index.
+    void remove_from_date_index(std::size_t position); // Called before the statement at position is erased or moved.
+    void insert_in_date_index(std::size_t position); // Called once the statement at position is in place.
+    void shift_date_index(std::size_t first, std::size_t last, std::ptrdiff_t offset); // Called when the statements in [first, last) move by offset.
+    void rotate_commit_state(std::size_t from, std::size_t to); // Called when the statement at from moved to to, the ones in between shifting by one.
+    void truncate_sorted_prefix(const_iterator position) { sorted_size_ = std::min<std::size_t>(sorted_size_, position - begin()); }; // Called when the statement at position changes.
+    std::size_t sorted_prefix_size(void) const; // Computes the length of the sorted prefix of statements_.
+    static std::size_t owned_memory(statement_type const & statement); // Returns the memory a statement owns on the heap: its composed entries and the text of its descriptions.
+    void check_total_amount(void) const; // Asserts that total_amount_ matches the statements in debug builds, once every size() edits.
+    bool has_handles(void) const { return !position_slots_.empty(); }; // Handles are only tracked once the first one is taken.
+    bool journaling(void) const { return 0 != journal_limit_ && !replaying_; }; // Edits made while replaying the journal record their inverse themselves.
+    void free_slot(std::uint32_t slot);
+    void replace_handles(std::size_t first, std::size_t last, std::size_t inserted); // Called when [first, last) is replaced by inserted statements.
+    void update_handle_positions(std::size_t first, std::size_t last); // Called when the statements in [first, last) moved.
 
   private:
     QString name_;
     QString currency_;
     vector_type statements_;
+    SelectionBitmap commit_states_; // commit state of each statement, none is committed in non-committable listings.
+    Money total_amount_{ 0_USD }; // kept up to date by every mutation.
+    mutable std::size_t unchecked_edits_{ 0 }; // edits since total_amount_ was last checked against the statements.
+    std::size_t sorted_size_{ 0 }; // the first sorted_size_ statements are known to be sorted by date.
+    mutable boost::optional<ListingColumns> columns_; // lazily built columnar view of statements_.
+    mutable boost::optional<date_index_type> date_index_; // lazily built positions of statements_, sorted by date and then by position.
+    mutable std::size_t date_index_sorted_size_{ 0 }; // the positions appended past the sorted prefix of date_index_ wait for the next query.
+    mutable boost::optional<BlockChecksums> block_checksums_; // lazily computed, stale blocks are rehashed on demand.
+
+    struct slot_type
+    {
+      std::uint32_t position; // position of the statement in statements_, no_slot if the slot is free or parked in a journal record.
+      std::uint32_t generation; // incremented each time the slot is freed.
+    };
+    static constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> position_slots_; // slot of each statement or no_slot, empty until the first handle is taken.
+    std::vector<slot_type> slots_;
+    std::vector<std::uint32_t> free_slots_;
+
+    struct splice_record
+    {
+      std::size_t position;
+      std::size_t count; // the count statements at position are replaced by statements.
+      vector_type statements;
+      SelectionBitmap commit_states; // commit state of statements.
+      std::vector<std::uint32_t> slots; // slot parked for each of statements, or no_slot. Empty when no statement had a handle.
+      bool keeps_handle; // the first of statements takes the handle of the first replaced statement, as altered and split statements do.
+    };
+    struct move_record { std::size_t from; std::size_t to; };
+    struct swap_record { std::size_t position1; std::size_t position2; };
+    using journal_record = std::variant<splice_record, move_record, swap_record>;
+
+    void journal(journal_record record);
+    void journal_replacement(std::size_t position, std::size_t count, vector_type replaced); // Records that count statements at position replaced the ones in replaced.
+    void trim_journal(void);
+    void forget(journal_record const & record); // Frees the slots parked in a record that is dropped from the journal.
+    void splice_handles(splice_record const & record, splice_record & inverse); // Parks the handles of the statements a splice replaces in its inverse, and gives the inserted statements theirs back.
+    static std::size_t record_size(journal_record const & record); // Estimates the memory held by a record, as memory_usage does for the listing.
+    journal_record replay(journal_record record); // Applies a record and returns its inverse.
+    splice_record splice(splice_record record); // Replaces count statements at position and returns the inverse record.
+
+    std::deque<journal_record> undo_records_; // the inverse of each edit, the last edit last.
+    std::vector<journal_record> redo_records_;
+    std::size_t journal_limit_{ 0 };
+    std::size_t journal_size_{ 0 };
+    bool replaying_{ false };
+  };
+
+  /// A batch of edits of a listing, applied in a single linear pass by commit.
+  ///
+  /// Edits designate statements by their iterators in the listing as it is before the commit, and the listing must not be
+  /// modified until then. A statement can only be erased, moved, grouped or altered once per transaction, a second edit throws
+  /// StatementEditedTwice and is not recorded. Statements inserted, moved or grouped before the same position end up in the order
+  /// the edits were recorded, and before the statement at that position. Handles are kept, except those of erased and grouped statements.
+  template<typename COMMITTABLE> class Listing<COMMITTABLE>::Transaction
+  {
+  public:
+    explicit Transaction(Listing & listing); /// Creates an empty transaction on a listing.
+
+  public:
+    Transaction & erase(const_iterator statement); /// Erases a statement.
+    Transaction & move(const_iterator statement, const_iterator position); /// Moves a statement before position, which may be end().
+    Transaction & group(QString description, QDate date, const_range statements); /// Replaces a range of statements by a single one composed of their entries.
+
+    /// Inserts the statement constructed from the arguments before position, which may be end().
+    template <class... ARGS> Transaction & insert(const_iterator position, ARGS && ... args)
+    {
+      insertions_.push_back({ this->position(position), false, new_statements_.size() });
+      new_statements_.emplace_back(std::forward<ARGS>(args)...);
+      return *this;
+    };
+
+    /// Replaces a statement by the one constructed from the arguments.
+    template <class... ARGS> Transaction & alter(const_iterator statement, ARGS && ... args)
+    {
+      assert(listing_.end() > statement);
+      mark_edited(position(statement), position(statement) + 1);
+      alterations_.emplace_back(position(statement), new_statements_.size());
+      new_statements_.emplace_back(std::forward<ARGS>(args)...);
+      return *this;
+    };
+
+    void commit(void); /// Applies the edits to the listing in linear time and clears the transaction.
+    void clear(void); /// Discards the edits.
+    bool empty(void) const { return removed_.empty() && alterations_.empty() && insertions_.empty() && groups_.empty(); };
+
+  private:
+    std::size_t position(const_iterator statement) const { return static_cast<std::size_t>(statement - listing_.begin()); };
+    void mark_edited(std::size_t first, std::size_t last); // Throws StatementEditedTwice if a statement in [first, last) is already edited, marks them otherwise.
+
+  private:
+    struct insertion_type
+    {
+      std::size_t position; // the statement is inserted before the original statement at position.
+      bool original; // true if source is the position of a moved statement, false if it is an index in new_statements_.
+      std::size_t source;
+    };
+
+    struct group_type
+    {
+      std::size_t first;
+      std::size_t last;
+      QString description;
+      QDate date;
+      std::size_t statement; // index of the group in new_statements_, reserved when the group is recorded.
+    };
+
+    Listing & listing_;
+    SelectionBitmap edited_; // the erased, moved, grouped and altered statements.
+    std::vector<std::size_t> removed_; // positions of the erased and grouped statements.
+    std::vector<std::pair<std::size_t, std::size_t>> alterations_; // position of an altered statement and index of its replacement in new_statements_.
+    std::vector<insertion_type> insertions_;
+    std::vector<group_type> groups_;
+    std::vector<statement_type> new_statements_;
   };
 
   template<typename COMMITTABLE> std::ostream & operator<<(std::ostream & stream, Listing<COMMITTABLE> const & listing);
   template<typename COMMITTABLE> std::istream & operator>>(std::istream & stream, Listing<COMMITTABLE> & listing);
   template<typename COMMITTABLE> bool operator==(Listing<COMMITTABLE> const & lhs, Listing<COMMITTABLE> const & rhs) { return lhs.equals(rhs); };
 
+  /// Free function to format a statement of a committable listing into a std::ostream.
+  inline std::ostream & operator<<(std::ostream & stream, CommittableStatementReference const & statement) { return statement.write(stream); };
+
   // Definition of the tags
   struct committable_tag
   {
-    using statement_type = CommittableStatement;
+    using statement_type = Statement; // the commit states are held by the listing.
   };
 
   struct non_committable_tag
@@ -0,0 +1,88 @@
+/// \file listing_columns.hpp
+#pragma once
+#ifndef IO1_LISTING_COLUMNS_HPP
+#define IO1_LISTING_COLUMNS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <io1/money.hpp>
+#include "io1/entry.hpp"
+
+namespace io1
+{
+  /// A columnar (structure of arrays) snapshot of the statements of a listing.
+  ///
+  /// Only the main entry of each statement is recorded: its date as a number of days since 1970-01-01,
+  /// its amount in cents, its commit state in a bitmap and its description as an offset into a single string blob.
+  /// Scans over dates and amounts therefore read contiguous memory and are easily vectorized by the compiler.
+  class ListingColumns
+  {
+  public:
+    using day_type = std::int32_t;
+    using amount_type = decltype(std::declval<Money>().data());
+    using word_type = std::uint64_t;
+
+  public:
+    ListingColumns(void) =default; /// Creates empty columns.
+    template<typename RANGE> explicit ListingColumns(RANGE const & statements); /// Creates the columns of a range of statements.
+
+    template<typename STATEMENT> void push_back(STATEMENT const & statement); /// Appends a statement to the columns.
+    void push_back(Entry const & main_entry, bool committed); /// Appends the main entry of a statement to the columns.
+    void set_committed(std::size_t position, bool committed); /// Changes the commit state of a statement.
+    void reserve(std::size_t size); /// Reserves memory for size statements.
+    void clear(void); /// Removes all statements.
+
+  public:
+    std::size_t size(void) const { return days_.size(); }; /// Returns the number of statements.
+    bool empty(void) const { return days_.empty(); };
+
+    std::vector<day_type> const & days(void) const { return days_; }; /// Returns the dates of the statements as a number of days since 1970-01-01.
+    std::vector<amount_type> const & amounts(void) const { return amounts_; }; /// Returns the amounts of the statements in cents.
+    std::vector<word_type> const & committed(void) const { return committed_; }; /// Returns the commit state of the statements, one bit per statement.
+    std::string_view description(std::size_t position) const; /// Returns the description of a statement.
+    bool is_committed(std::size_t position) const { return (committed_[position / word_bits] >> (position % word_bits)) & 1; }; /// Returns the commit state of a statement.
+
+    static day_type to_day(std::chrono::year_month_day const & date); /// Converts a date into a day number.
+    static std::chrono::year_month_day to_date(day_type day); /// Converts a day number back into a date.
+
+  public:
+    Money sum(void) const; /// Returns the total amount of the statements.
+    Money sum(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const; /// Returns the total amount of the statements dated within [from, to].
+    std::pair<Money, Money> minmax_amount(void) const; /// Returns the smallest and the largest amount. The columns must not be empty.
+    std::pair<day_type, day_type> minmax_day(void) const; /// Returns the earliest and the latest day number. The columns must not be empty.
+    std::vector<std::uint32_t> filter(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const; /// Returns the positions of the statements dated within [from, to], in listing order.
+    std::size_t committed_count(void) const; /// Returns the number of committed statements.
+    std::vector<amount_type> running_balances(Money initial_balance) const; /// Returns the balance after each statement, starting from initial_balance.
+
+  private:
+    static constexpr std::size_t word_bits = 64;
+
+    std::vector<day_type> days_;
+    std::vector<amount_type> amounts_;
+    std::vector<word_type> committed_;
+    std::vector<std::uint32_t> description_offsets_{ 0 }; // description i spans [description_offsets_[i], description_offsets_[i+1]).
+    std::string descriptions_;
+  };
+}
+
+// Constructor from a range of statements.
+template<typename RANGE> io1::ListingColumns::ListingColumns(RANGE const & statements)
+{
+  reserve(statements.size());
+  for (auto const & statement : statements) push_back(statement);
+}
+
+// Appends a statement, whether it is committable or not.
+template<typename STATEMENT> void io1::ListingColumns::push_back(STATEMENT const & statement)
+{
+  if constexpr (requires { statement.is_committed(); })
+    push_back(statement.main_entry(), statement.is_committed());
+  else
+    push_back(statement.main_entry(), false);
+}
+
+#endif
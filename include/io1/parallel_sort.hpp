@@ -0,0 +1,79 @@
+/// \file parallel_sort.hpp
+#pragma once
+#ifndef IO1_PARALLEL_SORT_HPP
+#define IO1_PARALLEL_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace io1
+{
+  /// Sorts [first, last) on up to thread_count threads, keeping the relative order of equivalent elements.
+  ///
+  /// The range is cut into one chunk per thread, chunks are stable sorted concurrently, then adjacent chunks are merged
+  /// pairwise, also concurrently, until a single one remains. A chunk is always merged with the one that follows it,
+  /// which keeps the sort stable. Ranges too small to be worth a thread are sorted on the calling thread.
+  template<typename RANDOM_IT, typename COMPARE> void parallel_stable_sort(RANDOM_IT first, RANDOM_IT last, COMPARE compare, unsigned thread_count);
+
+  /// Same as parallel_stable_sort, but equivalent elements may be reordered.
+  template<typename RANDOM_IT, typename COMPARE> void parallel_sort(RANDOM_IT first, RANDOM_IT last, COMPARE compare, unsigned thread_count);
+
+  namespace detail
+  {
+    inline constexpr std::ptrdiff_t parallel_sort_min_chunk = 1 << 14; // smaller chunks cost more to schedule than to sort.
+
+    // Calls task(i) for i in [0, count), on count threads. The calling thread runs task(0).
+    template<typename TASK> void run_on_threads(std::size_t count, TASK const & task)
+    {
+      std::vector<std::jthread> threads;
+      threads.reserve(count - 1);
+      for (std::size_t i = 1; count > i; ++i) threads.emplace_back(task, i);
+      task(0);
+    }
+
+    // Sorts the chunks with sort_chunk and merges them.
+    template<typename RANDOM_IT, typename COMPARE, typename SORT> void parallel_merge_sort(RANDOM_IT first, RANDOM_IT last, COMPARE compare, unsigned thread_count, SORT sort_chunk)
+    {
+      auto const size = last - first;
+      auto const chunk_count = static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(size / parallel_sort_min_chunk, 1, std::max(1u, thread_count)));
+      if (1 == chunk_count) return sort_chunk(first, last, compare);
+
+      // chunk i spans [bounds[i], bounds[i+1]).
+      std::vector<RANDOM_IT> bounds;
+      bounds.reserve(chunk_count + 1);
+      for (std::size_t i = 0; chunk_count > i; ++i) bounds.push_back(first + static_cast<std::ptrdiff_t>(i * static_cast<std::size_t>(size) / chunk_count));
+      bounds.push_back(last);
+
+      run_on_threads(chunk_count, [&](std::size_t i) { sort_chunk(bounds[i], bounds[i + 1], compare); });
+
+      while (2 < bounds.size())
+      {
+        auto const merge_count = (bounds.size() - 1) / 2;
+        run_on_threads(merge_count, [&](std::size_t i) { std::inplace_merge(bounds[2 * i], bounds[2 * i + 1], bounds[2 * i + 2], compare); });
+
+        // drop the bounds between merged chunks, an odd chunk left at the end is carried over as is.
+        std::vector<RANDOM_IT> merged_bounds;
+        merged_bounds.reserve(bounds.size() / 2 + 1);
+        for (std::size_t i = 0; bounds.size() > i; i += 2) merged_bounds.push_back(bounds[i]);
+        if (last != merged_bounds.back()) merged_bounds.push_back(last);
+        bounds = std::move(merged_bounds);
+      }
+    }
+  }
+}
+
+// Parallel merge sort with stable chunk sorts.
+template<typename RANDOM_IT, typename COMPARE> void io1::parallel_stable_sort(RANDOM_IT first, RANDOM_IT last, COMPARE compare, unsigned thread_count)
+{
+  return detail::parallel_merge_sort(first, last, compare, thread_count, [](RANDOM_IT begin, RANDOM_IT end, COMPARE const & predicate) { std::stable_sort(begin, end, predicate); });
+}
+
+// Parallel merge sort with unstable chunk sorts.
+template<typename RANDOM_IT, typename COMPARE> void io1::parallel_sort(RANDOM_IT first, RANDOM_IT last, COMPARE compare, unsigned thread_count)
+{
+  return detail::parallel_merge_sort(first, last, compare, thread_count, [](RANDOM_IT begin, RANDOM_IT end, COMPARE const & predicate) { std::sort(begin, end, predicate); });
+}
+
+#endif
@@ -0,0 +1,26 @@
+/// \file running_balance.hpp
+#pragma once
+#ifndef IO1_RUNNING_BALANCE_HPP
+#define IO1_RUNNING_BALANCE_HPP
+
+#include <span>
+#include "io1/listing_columns.hpp"
+
+namespace io1
+{
+  using balance_type = ListingColumns::amount_type;
+
+  /// Writes into balances the running balance after each amount, starting from initial_balance: balances[i] = initial_balance + amounts[0] + ... + amounts[i].
+  ///
+  /// The prefix sum uses AVX2 when the processor supports it and falls back to running_balance_scalar otherwise.
+  /// balances must be at least as large as amounts and may be the same span.
+  void running_balance(std::span<balance_type const> amounts, balance_type initial_balance, std::span<balance_type> balances);
+
+  /// Portable implementation of running_balance.
+  void running_balance_scalar(std::span<balance_type const> amounts, balance_type initial_balance, std::span<balance_type> balances);
+
+  /// Returns true if running_balance uses the AVX2 kernel.
+  bool running_balance_uses_avx2(void);
+}
+
+#endif
@@ -0,0 +1,84 @@
+/// \file selection_bitmap.hpp
+#pragma once
+#ifndef IO1_SELECTION_BITMAP_HPP
+#define IO1_SELECTION_BITMAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/iterator/iterator_facade.hpp>
+
+namespace io1
+{
+  /// A dense selection of statements, one bit per statement of a listing.
+  ///
+  /// Selecting, unselecting and testing a statement are constant time, counting and iterating over the selected
+  /// statements go through the bitmap one 64 bits word at a time, which makes large selections much cheaper to build
+  /// than a statement_selection. Positions are those of the statements in the listing at the time of the selection.
+  class SelectionBitmap
+  {
+  public:
+    using word_type = std::uint64_t;
+    static constexpr std::size_t word_bits = 64;
+
+    /// A forward iterator over the positions of the selected statements, in increasing order.
+    class const_iterator : public boost::iterator_facade<const_iterator, std::size_t const, boost::forward_traversal_tag, std::size_t>
+    {
+    public:
+      const_iterator(void) =default;
+      explicit const_iterator(SelectionBitmap const * bitmap, std::size_t position) :bitmap_(bitmap), position_(position) {};
+
+    private:
+      friend class boost::iterator_core_access;
+
+      std::size_t dereference(void) const { return position_; };
+      bool equal(const_iterator const & rhs) const { return position_ == rhs.position_; };
+      void increment(void) { position_ = bitmap_->find_next(position_ + 1); };
+
+    private:
+      SelectionBitmap const * bitmap_{ nullptr };
+      std::size_t position_{ 0 };
+    };
+
+  public:
+    SelectionBitmap(void) =default;
+    explicit SelectionBitmap(std::size_t size) :size_(size), words_((size + word_bits - 1) / word_bits, 0) {}; /// Creates an empty selection for size statements.
+
+    void set(std::size_t position) { words_[position / word_bits] |= mask(position); }; /// Selects a statement.
+    void reset(std::size_t position) { words_[position / word_bits] &= ~mask(position); }; /// Unselects a statement.
+    void assign(std::size_t position, bool selected) { selected ? set(position) : reset(position); }; /// Selects or unselects a statement.
+    bool test(std::size_t position) const { return 0 != (words_[position / word_bits] & mask(position)); }; /// Returns true if a statement is selected.
+    void set_all(void); /// Selects every statement.
+    void clear(void); /// Unselects every statement.
+    void flip(void); /// Selects the statements that were not selected and unselects the others.
+    void push_back(bool selected); /// Grows the selection by one statement.
+    void insert(std::size_t position, std::size_t count, bool selected); /// Inserts count statements before position, shifting the following ones a word at a time.
+    void erase(std::size_t first, std::size_t last); /// Removes the statements in [first, last), shifting the following ones a word at a time.
+
+  public:
+    std::size_t size(void) const { return size_; }; /// Returns the number of statements the selection is sized for.
+    std::size_t count(void) const; /// Returns the number of selected statements.
+    bool none(void) const; /// Returns true if no statement is selected.
+    std::size_t find_first(void) const { return find_next(0); }; /// Returns the position of the first selected statement, or size() if there is none.
+    std::size_t find_next(std::size_t position) const; /// Returns the position of the first selected statement at or after position, or size() if there is none.
+    std::size_t find_last(void) const; /// Returns the position of the last selected statement, or size() if there is none.
+    std::vector<word_type> const & words(void) const { return words_; }; /// Returns the bitmap, statement i is bit i % 64 of word i / 64.
+
+    const_iterator begin(void) const { return const_iterator(this, find_first()); };
+    const_iterator end(void) const { return const_iterator(this, size_); };
+    bool operator==(SelectionBitmap const & rhs) const =default;
+
+  private:
+    static word_type mask(std::size_t position) { return word_type{ 1 } << (position % word_bits); };
+    word_type load(std::size_t position) const; // Returns the 64 bits from position on, bits past size_ are zero.
+    void move_bits(std::size_t from, std::size_t to, std::size_t count); // Copies count bits from from to to, the ranges may overlap.
+    void clear_tail(void); // Clears the bits past size_.
+
+  private:
+    std::size_t size_{ 0 };
+    std::vector<word_type> words_; // bits past size_ are always zero.
+  };
+}
+
+#endif
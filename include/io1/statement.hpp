@@ -4,6 +4,9 @@
 #define IO1_STATEMENT_HPP
 
 #include <iosfwd>
+#include <algorithm>
+#include <span>
+#include <string_view>
 
 #include <boost/container/small_vector.hpp>
 #include <boost/range/iterator_range.hpp>
@@ -40,6 +43,7 @@ namespace io1
     explicit Statement(Money amount, QString const & description); /// Creates a statement with the given amount and description, dated today.
     explicit Statement(Money amount, QString const & description, QDate date); /// Creates a statement with the given amount, description and date.
     template<typename RANGE> explicit Statement(QString const & description, QDate date, RANGE range); /// Creates a statement from a range of entries with the given description and date.
+    explicit Statement(std::span<Entry const> entries); /// Creates a statement from its main entry followed by its composed entries, as returned by main_entry() and composed_entries().
 
   public:
     QDate const & date(void) const { return main_entry().date(); }; /// Returns the date of the statement.
@@ -52,14 +56,23 @@ namespace io1
     bool is_composed(void) const { return 1 < entries_.size(); }; /// Returns true if the statement is more than a single entry.
     std::size_t entry_count(void) const; /// Returns the number of composed entries. Returns zero if is_composed() returns false.
 
+    /// Moves the entries the statement is made of into an output iterator: the main entry if the statement is not composed, the composed entries otherwise.
+    /// These are the entries a group or a split is made of. The statement can then only be assigned.
+    template<typename OUT> OUT move_entries_to(OUT out);
+
   public:
     std::ostream & write(std::ostream & stream) const { return write_impl(stream); }; /// Writes the statement into a std::ostream using UTF8.
+    template<typename OUT> OUT format_to(OUT out, std::string_view prefix = {}) const; /// Formats the statement into an output iterator using UTF8 and prepending a prefix to each line.
     static Statement read(std::istream & stream); /// Reads a statement from a UTF8 std::istream.
+    static std::size_t read(std::string_view buffer, Statement & statement); /// Reads a statement from the beginning of a UTF8 buffer and returns the number of bytes consumed.
     bool equals(Statement const & rhs) const; /// Returns true if rhs equals the object.
 
   protected:
+    static constexpr char composed_char = '-'; // the character that starts the line of a composed entry.
+
     std::ostream & write_impl(std::ostream & stream, char const * prefix ="") const; /// Writes the statement into a std::ostream using UTF8 and prepending a prefix to each line.
     template<typename STATEMENT> static STATEMENT read_impl(std::istream & stream); /// Reads a generic statement from a stream using UTF8.
+    template<typename STATEMENT> static std::size_t read_impl(std::string_view buffer, STATEMENT & statement); /// Reads a generic statement from a buffer using UTF8.
 
   private:
     small_vector_t entries_; // The main entry followed by the composed ones if any.
@@ -90,13 +103,22 @@ namespace io1
     template <class... ARGS> explicit CommittableStatement(ARGS && ... args):Statement(std::forward<ARGS>(args)...) {}; /// Forwards construction to Statement.
 
     bool is_committed() const { return is_committed_; }; /// Returns the commit state of the statement.
-    void set_committed(bool committed=true) const { is_committed_ = committed; }; /// changes the commit state of the statement.
+    void set_committed(bool committed=true) { is_committed_ = committed; }; /// changes the commit state of the statement. Statements of a listing are changed through Listing::set_committed.
 
     std::ostream & write(std::ostream & stream) const; /// Formats the statement into a std::ostream using UTF8.
+    template<typename OUT> OUT format_to(OUT out) const { return format_to(std::move(out), *this, is_committed()); }; /// Formats the statement into an output iterator using UTF8.
     static CommittableStatement read(std::istream & stream); /// Reads a statement from a UTF8 std::istream.
+    static std::size_t read(std::string_view buffer, CommittableStatement & statement); /// Reads a statement from the beginning of a UTF8 buffer and returns the number of bytes consumed.
+
+    /// Same as above, for statements whose commit state is held elsewhere, such as the statements of a committable listing.
+    template<typename OUT> static OUT format_to(OUT out, Statement const & statement, bool committed);
+    static Statement read(std::istream & stream, bool & committed);
+    static std::size_t read(std::string_view buffer, Statement & statement, bool & committed);
 
   private:
-    mutable bool is_committed_{ false }; // the boolean thet holds the commit state.
+    static constexpr char committed_char = '#'; // the character that starts the line of a committed statement.
+
+    bool is_committed_{ false }; // the boolean thet holds the commit state.
   };
 
   /// Free function to format a committable statement into a std::ostream.
@@ -130,4 +152,38 @@ template<typename RANGE> io1::Statement::Statement(QString const & description,
   assert(1 <= entries_.size());
 }
 
+// Moves the entries out, the main entry of a composed statement is left behind as it is recomputed by groups.
+template<typename OUT> OUT io1::Statement::move_entries_to(OUT out)
+{
+  auto const first = is_composed() ? ++entries_.begin() : entries_.begin();
+  auto last = std::move(first, entries_.end(), std::move(out));
+  entries_.clear();
+
+  return last;
+}
+
+// Formats a statement into an output iterator, the composed entries are indented by the size of the prefix.
+template<typename OUT> OUT io1::Statement::format_to(OUT out, std::string_view prefix) const
+{
+  out = std::copy(prefix.begin(), prefix.end(), std::move(out));
+  out = entries_.front().format_to(std::move(out));
+
+  for (auto const & composed_entry : composed_entries())
+  {
+    out = std::fill_n(std::move(out), prefix.size(), ' ');
+    *out++ = composed_char;
+    *out++ = ' ';
+    out = composed_entry.format_to(std::move(out));
+  }
+
+  return out;
+}
+
+// Formats a statement and its commit state into an output iterator.
+template<typename OUT> OUT io1::CommittableStatement::format_to(OUT out, Statement const & statement, bool committed)
+{
+  char const prefix[2] = { committed ? committed_char : ' ', ' ' };
+  return statement.format_to(std::move(out), std::string_view(prefix, 2));
+}
+
 #endif
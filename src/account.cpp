@@ -1,15 +1,22 @@
 #include "account.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <thread>
 #include <boost/format.hpp>
-#include <boost/range/adaptor/filtered.hpp>
-#include <boost/range/numeric.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/exception/errinfo_file_name.hpp>
 #include <boost/exception/errinfo_errno.hpp>
 #include <boost/exception/errinfo_nested_exception.hpp>
 #include <boost/exception_ptr.hpp>
+#include "archive_writer.hpp"
 #include "date_formatter.hpp"
-#include "sha1_sum_filter.hpp"
 #include "calculate_current_line.hpp"
 #include "accounting_exception.hpp"
 
@@ -17,33 +24,159 @@ namespace
 {
   auto const currency_marker = "\xc2\xa4";
 
-  template <class RANGE> io1::Money accumulate (RANGE const & range, io1::Money initial_value)
+  std::string const listing_extension = ".lst";
+  std::string const block_index_extension = ".blk";
+
+  io1::Checksum write_statements(io1::Account::current_listing_type const & statements, boost::filesystem::path const & filename, io1::HashAlgorithm algorithm)
   {
-    return boost::accumulate(range,initial_value,[](io1::Money acc, typename RANGE::const_iterator::reference statement){ return acc += statement.amount(); });
+    // the file must outlive the chain, which flushes and closes it when destroyed.
+    boost::filesystem::ofstream file(filename);
+
+    boost::iostreams::filtering_ostream out;
+    io1::ChecksumFilter const filter(algorithm);
+
+    out.push(filter);
+    out.push(file);
+    out << statements << std::flush;
+
+    return filter.checksum();
   };
 
-  std::string const listing_extension = ".lst";
+  // The listing file is written whole, but only the blocks that edits made stale are hashed. Returns the checksum of the index.
+  io1::Checksum write_block_statements(io1::Account::current_listing_type const & statements, boost::filesystem::path const & filename, boost::filesystem::path const & index_filename, io1::HashAlgorithm algorithm, std::size_t block_size)
+  {
+    auto const & checksums = statements.block_checksums(algorithm, block_size);
+
+    boost::filesystem::ofstream(filename) << statements;
+    boost::filesystem::ofstream(index_filename) << checksums;
+
+    return checksums.root();
+  };
 
-  std::string write_statements(io1::Account::current_listing_type const & statements, boost::filesystem::path const & filename)
+  // The whole file is hashed as it is parsed.
+  io1::Account::current_listing_type read_statements(boost::filesystem::path const & filename, io1::Checksum const & checksum)
   {
-    boost::iostreams::filtering_ostream out;
-    auto const filter = io1::push<io1::sha1_sum_filter>(out);
-    assert(filter);
+    boost::iostreams::filtering_istream in;
+    io1::ChecksumFilter const filter(checksum.algorithm());
+    in.push(filter);
+
+    io1::Account::current_listing_type listing;
+    {
+      boost::filesystem::ifstream file(filename);
+      if (!file) BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename.string()));
+
+      in.push(file);
+
+      try
+      {
+        in >> listing;
+      }
+      catch (io1::ParseError & e)
+      {
+        e << io1::ParseError::errinfo_line_number(io1::calculate_current_line(file));
+        BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_file_name(filename.string()) << boost::errinfo_nested_exception(boost::current_exception()));
+      }
+    }
+
+    auto const actual_checksum = filter.checksum();
+    if (checksum != actual_checksum) BOOST_THROW_EXCEPTION(io1::Sha1Mismatch() << io1::Sha1Mismatch::errinfo_actual(actual_checksum.to_string()) << io1::Sha1Mismatch::errinfo_expected(checksum.to_string()));
+
+    return listing;
+  };
+
+  // The index is checked against the root checksum, then each block of the mapped listing file against the index. The listing
+  // keeps the checksums, so that saving it again only rehashes the blocks that are edited in the meantime.
+  io1::Account::current_listing_type read_block_statements(boost::filesystem::path const & filename, boost::filesystem::path const & index_filename, io1::Checksum const & root, std::size_t & block_size)
+  {
+    boost::filesystem::ifstream index_file(index_filename);
+    if (!index_file) BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(index_filename.string()));
+    std::string const index(std::istreambuf_iterator<char>(index_file), {});
+
+    auto const actual_root = io1::checksum(root.algorithm(), index);
+    if (root != actual_root) BOOST_THROW_EXCEPTION(io1::Sha1Mismatch() << io1::Sha1Mismatch::errinfo_actual(actual_root.to_string()) << io1::Sha1Mismatch::errinfo_expected(root.to_string()) << boost::errinfo_file_name(index_filename.string()));
 
+    std::istringstream index_stream(index);
+    auto checksums = io1::BlockChecksums::read(index_stream);
+
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+      file.open(filename.string());
+    }
+    catch (std::ios_base::failure const &)
     {
-      boost::filesystem::ofstream file(filename);
-      out.push(file);
-      out << statements;
+      BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename.string()));
+    }
+    std::string_view const content{ file.data(), file.size() };
+
+    try
+    {
+      checksums.verify(content);
+    }
+    catch (io1::Sha1Mismatch & e)
+    {
+      e << boost::errinfo_file_name(filename.string());
+      throw;
     }
 
-    return filter->read_sha1();
+    io1::Account::current_listing_type listing;
+    try
+    {
+      listing = io1::Account::current_listing_type::read(content);
+    }
+    catch (io1::ParseError const &)
+    {
+      BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_file_name(filename.string()) << boost::errinfo_nested_exception(boost::current_exception()));
+    }
+
+    block_size = checksums.block_size();
+    listing.adopt_block_checksums(std::move(checksums));
+    return listing;
   };
 
-  bool starts_with_sha1(std::string const & line)
+  // The current listing line holds its checksum and its file name, separated by a tab, then the name of its block index if it has one.
+  bool parse_listing_line(std::string const & line, io1::Checksum & checksum, std::string & filename, std::string & index_filename)
   {
-    return (40 == line.find_first_not_of("0123456789abcdef"));
+    auto const tab = line.find('\t');
+    if (std::string::npos == tab || !io1::Checksum::parse(std::string_view(line).substr(0, tab), checksum)) return false;
+
+    auto const index_tab = line.find('\t', tab + 1);
+    filename = line.substr(tab + 1, index_tab - tab - 1);
+    index_filename = (std::string::npos == index_tab) ? std::string() : line.substr(index_tab + 1);
+    return true;
   };
 
+  // Hashes the archive files on up to thread_count threads, each taking the next archive left, since their sizes vary a lot.
+  // Every archive is checked, then the failure of the earliest archive is rethrown so that the error does not depend on scheduling.
+  void verify_archives(std::vector<io1::ArchivedListing> const & archives, unsigned thread_count)
+  {
+    if (0 == thread_count) thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::exception_ptr> errors(archives.size());
+    std::atomic<std::size_t> next_archive{ 0 };
+    auto const verify = [&]
+    {
+      for (auto i = next_archive++; archives.size() > i; i = next_archive++)
+      {
+        try
+        {
+          archives[i].verify();
+        }
+        catch (...)
+        {
+          errors[i] = std::current_exception();
+        }
+      }
+    };
+
+    {
+      std::vector<std::jthread> threads;
+      for (std::size_t i = 1; std::min<std::size_t>(thread_count, archives.size()) > i; ++i) threads.emplace_back(verify);
+      verify();
+    }
+
+    for (auto const & error : errors) if (error) std::rethrow_exception(error);
+  }
 }
 
 io1::Account::Account(Money initial_balance, QString currency)
@@ -54,7 +187,7 @@ io1::Account::Account(Money initial_balance, QDate date, QString currency)
 :currency_(std::move(currency))
 {
   auto const st_it = current_listing_.add_statement(initial_balance,"Initial balance.",std::move(date));
-  st_it->set_committed();
+  current_listing_.set_committed(st_it);
 }
 
 io1::Account::Account(current_listing_type current_listing, std::vector<ArchivedListing> archives, QString description, QString currency)
@@ -66,7 +199,12 @@ io1::Account::Account(current_listing_type current_listing, std::vector<Archived
 
 io1::Money io1::Account::balance(void) const
 {
-  return accumulate(current_listing_,archived_balance());
+  return archived_balance() + current_listing_.total_amount();
+}
+
+std::vector<io1::ListingColumns::amount_type> io1::Account::running_balances(void) const
+{
+  return current_listing_.columns().running_balances(archived_balance());
 }
 
 io1::Money io1::Account::archived_balance(void) const
@@ -74,28 +212,48 @@ io1::Money io1::Account::archived_balance(void) const
   return archived_listings_.empty() ? 0_USD : archived_listings_.back().final_balance();
 }
 
-void io1::Account::archive(QString name)
+io1::ArchivedListing::shared_listing_type io1::Account::archived_listing(std::size_t index) const
 {
-  using statement_type = typename current_listing_type::statement_type;
-  
-  auto const committed_range = current_listing_.statements() | boost::adaptors::filtered([](statement_type const & st) {return st.is_committed(); });
-  ArchivedListing::listing_type archived_listing(std::move(name),committed_range);
-  archived_listing.stable_sort();
+  return archive_cache_.listing(archived_listings_.at(index));
+}
 
-  auto const un_committed_range = current_listing_.statements() | boost::adaptors::filtered([](statement_type const & st) {return !st.is_committed(); });
-  current_listing_type new_current_listing(current_listing_.name(),un_committed_range);
+// The file is streamed from the current listing and the committed statements are only moved out of it once the file is written, so that
+// a failed write leaves the account untouched and the statements are never copied. The archive holds them, sorted like the file, and
+// enters the archive cache, which may release them like any other.
+void io1::Account::archive(QString name)
+{
+  if (!write_archive(name, ArchiveWriter::default_memory_budget)) return; // nothing to archive.
 
-  auto const new_archived_balance = accumulate(archived_listing, archived_balance());
+  auto archived_listing = current_listing_.extract_committed(std::move(name));
+  archived_listing.stable_sort(); // the order of the file: by date, then by position in the current listing.
+  archived_listings_.back().hold_listing(std::move(archived_listing));
+  archive_cache_.listing(archived_listings_.back());
 
-  QDate const archived_date = archived_listing.statements().back().date();
-  auto const archive_filename = name.toStdString() + listing_extension;
+  return;
+}
 
-  archived_listings_.emplace_back(archive_filename, std::move(archived_listing), archived_date, new_archived_balance);
-  std::swap(current_listing_, new_current_listing);
+void io1::Account::archive(QString name, std::size_t memory_budget)
+{
+  if (write_archive(name, memory_budget)) current_listing_.erase_committed();
 
   return;
 }
 
+// The writer and its buffer are gone once the archive is added, before the committed statements are removed from the current listing.
+bool io1::Account::write_archive(QString const & name, std::size_t memory_budget)
+{
+  auto const & committed_statements = current_listing_.committed_statements();
+  if (committed_statements.none()) return false;
+
+  ArchiveWriter writer(name.toStdString() + listing_extension, name, archived_balance(), memory_budget, hash_algorithm_, archive_format_);
+  for (auto const position : committed_statements) writer.add(current_listing_.begin()[position]);
+
+  archived_listings_.reserve(archived_listings_.size() + 1);
+  archived_listings_.push_back(writer.finish());
+
+  return true;
+}
+
 std::ostream & io1::Account::write(std::ostream & stream) const
 {
   stream << description_.toStdString() << "\n\n";
@@ -103,9 +261,17 @@ std::ostream & io1::Account::write(std::ostream & stream) const
   if (!currency_.isEmpty()) stream << currency_marker << currency_.toStdString() << "\n\n";
   
   auto const current_listing_filename = current_listing_.name().toStdString() + listing_extension;
-  auto const current_listing_sha1 = write_statements(current_listing_,current_listing_filename);
-
-  stream << boost::format("%1%\t%2%\n") % current_listing_sha1 % current_listing_filename;
+  if (0 == block_size_)
+  {
+    auto const current_listing_checksum = write_statements(current_listing_,current_listing_filename,hash_algorithm_);
+    stream << boost::format("%1%\t%2%\n") % current_listing_checksum % current_listing_filename;
+  }
+  else
+  {
+    auto const index_filename = current_listing_.name().toStdString() + block_index_extension;
+    auto const root_checksum = write_block_statements(current_listing_, current_listing_filename, index_filename, hash_algorithm_, block_size_);
+    stream << boost::format("%1%\t%2%\t%3%\n") % root_checksum % current_listing_filename % index_filename;
+  }
 
   if (!archived_listings_.empty())
   {
@@ -120,14 +286,17 @@ std::ostream & io1::operator<<(std::ostream & stream, Account const & account)
   return account.write(stream);
 }
 
-io1::Account io1::Account::read(std::istream & stream)
+io1::Account io1::Account::read(std::istream & stream, OpenOptions const & options)
 {
   std::string line;
   std::string description;
   std::string currency;
+  Checksum checksum;
+  std::string listing_filename;
+  std::string index_filename;
 
   std::getline(stream >> std::ws, line);
-  while (stream && !starts_with_sha1(line))
+  while (stream && !parse_listing_line(line, checksum, listing_filename, index_filename))
   {
     if (0 == line.find(currency_marker))
     {
@@ -138,46 +307,23 @@ io1::Account io1::Account::read(std::istream & stream)
 
     std::getline(stream >> std::ws,line);
   }
-  if (!stream) BOOST_THROW_EXCEPTION(ParseError() << ParseError::errinfo_class_name("Account")); // file read error, a sha1 was expected at some point.
+  if (!stream) BOOST_THROW_EXCEPTION(ParseError() << ParseError::errinfo_class_name("Account")); // file read error, a checksum was expected at some point.
 
-  auto const sha1 = line.substr(0,40);
-  boost::filesystem::path filename = line.substr(40);
+  std::size_t block_size = 0;
+  auto current_listing = index_filename.empty() ? read_statements(listing_filename, checksum) : read_block_statements(listing_filename, index_filename, checksum, block_size);
 
-  boost::iostreams::filtering_istream in;
+  auto const verification = (OpenOptions::verification_type::serial == options.archive_verification) ? ArchivedListing::verification_type::immediate : ArchivedListing::verification_type::deferred;
 
-  auto const sha1_sum = push<sha1_sum_filter>(in);
-  assert(sha1_sum);
-
-  current_listing_type current_listing;
-  {
-    boost::filesystem::ifstream file(filename);
-    if (!file) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename.string()));
-
-    in.push(file);
-    
-    try
-    {
-      in >> current_listing;
-    }
-    catch (ParseError & e)
-    {
-      e << ParseError::errinfo_line_number(calculate_current_line(file));
-      BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_file_name(filename.string()) << boost::errinfo_nested_exception(boost::current_exception()));
-    }
-  }
+  std::vector<ArchivedListing> archives;
+  while ((stream >> std::ws).good()) archives.push_back(ArchivedListing::read(stream >> std::ws, verification));
 
-  auto const actual_sha1 = sha1_sum->read_sha1();
-  if (sha1 != actual_sha1) BOOST_THROW_EXCEPTION(Sha1Mismatch() << Sha1Mismatch::errinfo_actual(actual_sha1) << Sha1Mismatch::errinfo_expected(sha1));
+  if (OpenOptions::verification_type::parallel == options.archive_verification) verify_archives(archives, options.thread_count);
 
-  std::vector<ArchivedListing> archives;
-  while ((stream >> std::ws).good())
-  {
-    ArchivedListing ar;
-    stream >> std::ws >> ar;
-    archives.push_back(std::move(ar));
-  }
+  Account account(std::move(current_listing),std::move(archives),QString::fromStdString(description),QString::fromStdString(currency).trimmed());
+  account.hash_algorithm_ = checksum.algorithm(); // the account keeps protecting its files as it did.
+  account.block_size_ = block_size;
 
-  return Account(std::move(current_listing),std::move(archives),QString::fromStdString(description),QString::fromStdString(currency).trimmed());
+  return account;
 }
 
 std::istream & io1::operator>>(std::istream & stream, Account & account)
@@ -204,7 +350,7 @@ void io1::save_as(boost::filesystem::path const & path, Account const & account)
   return;
 }
 
-io1::Account io1::open(boost::filesystem::path const & path)
+io1::Account io1::open(boost::filesystem::path const & path, OpenOptions const & options)
 {
   boost::filesystem::ifstream file(path);
   if (!file) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(path.string()));
@@ -213,7 +359,7 @@ io1::Account io1::open(boost::filesystem::path const & path)
   {
     try
     {
-      return Account::read(file);
+      return Account::read(file, options);
     }
     catch (ParseError & e)
     {
@@ -47,3 +47,13 @@ void io1::ParseError::format_message(void) const
 
   return;
 }
+
+void io1::StatementEditedTwice::format_message(void) const
+{
+  if (auto const position = boost::get_error_info<errinfo_position>(*this))
+    message_ = str(boost::format("Statement %1%: ") % *position);
+
+  message_ += "A transaction can only erase, move, group or alter a statement once.";
+
+  return;
+}
@@ -0,0 +1,121 @@
+#include "archive_cache.hpp"
+#include <utility>
+
+io1::ArchiveCache::ArchiveCache(std::size_t memory_budget)
+:memory_budget_(memory_budget)
+{
+}
+
+io1::ArchiveCache::ArchiveCache(ArchiveCache const & rhs)
+:memory_budget_(rhs.memory_budget())
+{
+}
+
+io1::ArchiveCache & io1::ArchiveCache::operator=(ArchiveCache const & rhs)
+{
+  if (this == &rhs) return *this;
+
+  auto const memory_budget = rhs.memory_budget();
+  clear();
+
+  std::lock_guard const lock(mutex_);
+  memory_budget_ = memory_budget;
+
+  return *this;
+}
+
+// The listing is loaded without holding the cache lock, so that loading an archive does not block the readers of the others.
+// Concurrent misses on the same archive are serialized by the archive itself, which loads its listing once.
+io1::ArchivedListing::shared_listing_type io1::ArchiveCache::listing(ArchivedListing const & archive)
+{
+  auto const key = archive.filename().string();
+  {
+    std::lock_guard const lock(mutex_);
+    if (auto const found = index_.find(key); index_.end() != found)
+    {
+      ++statistics_.hits;
+      entries_.splice(entries_.begin(), entries_, found->second);
+      return found->second->listing;
+    }
+  }
+
+  auto listing = archive.listing();
+  auto const size = listing->memory_usage();
+
+  std::lock_guard const lock(mutex_);
+  if (auto const found = index_.find(key); index_.end() != found) // another thread got there first.
+  {
+    ++statistics_.hits;
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return found->second->listing;
+  }
+
+  ++statistics_.misses;
+  entries_.push_front({ archive, listing, size });
+  index_.emplace(key, entries_.begin());
+  memory_usage_ += size;
+  evict();
+
+  return listing;
+}
+
+void io1::ArchiveCache::clear(void)
+{
+  std::lock_guard const lock(mutex_);
+  for (auto const & entry : entries_) entry.archive.release_listing();
+
+  entries_.clear();
+  index_.clear();
+  memory_usage_ = 0;
+
+  return;
+}
+
+void io1::ArchiveCache::set_memory_budget(std::size_t bytes)
+{
+  std::lock_guard const lock(mutex_);
+  memory_budget_ = bytes;
+  evict();
+
+  return;
+}
+
+std::size_t io1::ArchiveCache::memory_budget(void) const
+{
+  std::lock_guard const lock(mutex_);
+  return memory_budget_;
+}
+
+std::size_t io1::ArchiveCache::memory_usage(void) const
+{
+  std::lock_guard const lock(mutex_);
+  return memory_usage_;
+}
+
+std::size_t io1::ArchiveCache::size(void) const
+{
+  std::lock_guard const lock(mutex_);
+  return entries_.size();
+}
+
+io1::ArchiveCache::statistics_type io1::ArchiveCache::statistics(void) const
+{
+  std::lock_guard const lock(mutex_);
+  return statistics_;
+}
+
+// The archive forgets its listing, which is freed once its last reader drops it.
+void io1::ArchiveCache::evict(void)
+{
+  while (memory_budget_ < memory_usage_ && 1 < entries_.size())
+  {
+    auto & entry = entries_.back();
+    entry.archive.release_listing();
+    memory_usage_ -= entry.size;
+    index_.erase(entry.archive.filename().string());
+    entries_.pop_back();
+    ++statistics_.evictions;
+  }
+
+  return;
+}
@@ -0,0 +1,253 @@
+#include "archive_writer.hpp"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <utility>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/throw_exception.hpp>
+#include "columnar_archive.hpp"
+#include "accounting_exception.hpp"
+
+namespace
+{
+  // Each statement of a run file is preceded by this header.
+  struct run_header_type
+  {
+    std::int64_t day;
+    std::uint64_t size;
+  };
+
+  // Reads the next statement of a run file, returns false at the end of the run.
+  bool read_run_statement(std::istream & run, boost::filesystem::path const & filename, io1::ListingColumns::day_type & day, std::string & statement)
+  {
+    run_header_type header;
+    if (!run.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+      if (0 == run.gcount()) return false;
+      BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_file_name(filename.string())); // truncated run.
+    }
+
+    day = static_cast<io1::ListingColumns::day_type>(header.day);
+    statement.resize(header.size);
+    if (!run.read(statement.data(), static_cast<std::streamsize>(header.size))) BOOST_THROW_EXCEPTION(io1::FileReadError() << boost::errinfo_file_name(filename.string()));
+
+    return true;
+  }
+
+  // Writes a statement at the end of a run file.
+  void write_run_statement(std::ostream & run, io1::ListingColumns::day_type day, std::string_view statement)
+  {
+    run_header_type const header{ day, statement.size() };
+    run.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    run.write(statement.data(), static_cast<std::streamsize>(statement.size()));
+  }
+
+  // Writes the statements into the archive file, write_statements(write) calls write(statement) with each formatted statement in
+  // order. Text archives get the header and then the statements as they are, columnar and compressed archives parse them back. Returns the checksum of the file.
+  template<typename WRITE> io1::Checksum write_archive(boost::filesystem::path const & filename, io1::HashAlgorithm algorithm, io1::ArchiveWriter::format_type format, std::string const & name, std::string const & header, WRITE write_statements)
+  {
+    auto const columnar = (io1::ArchiveWriter::format_type::text != format);
+
+    // the file must outlive the chain, which flushes and closes it when destroyed.
+    boost::filesystem::ofstream file(filename, columnar ? std::ios::out | std::ios::binary : std::ios::out);
+    if (!file) BOOST_THROW_EXCEPTION(io1::FileWriteError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename.string()));
+
+    boost::iostreams::filtering_ostream out;
+    io1::ChecksumFilter const filter(algorithm);
+
+    out.push(filter);
+    out.push(file);
+    if (columnar)
+    {
+      auto const encoding = (io1::ArchiveWriter::format_type::compressed == format) ? io1::ColumnarArchiveWriter::encoding_type::compressed : io1::ColumnarArchiveWriter::encoding_type::fixed;
+      io1::ColumnarArchiveWriter writer(out, name, algorithm, io1::ColumnarArchiveWriter::default_block_size, encoding);
+      io1::Statement statement;
+      write_statements([&](std::string_view formatted_statement)
+      {
+        io1::Statement::read(formatted_statement, statement);
+        writer.add(statement);
+      });
+      writer.finish();
+    }
+    else
+    {
+      out.write(header.data(), static_cast<std::streamsize>(header.size()));
+      write_statements([&out](std::string_view formatted_statement) { out.write(formatted_statement.data(), static_cast<std::streamsize>(formatted_statement.size())); });
+    }
+    out << std::flush;
+    if (!out || !file) BOOST_THROW_EXCEPTION(io1::FileWriteError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename.string()));
+
+    return filter.checksum();
+  }
+}
+
+io1::ArchiveWriter::ArchiveWriter(path_type filename, QString const & name, Money initial_balance, std::size_t memory_budget, HashAlgorithm algorithm, format_type format)
+:filename_(std::move(filename))
+,name_(name.toStdString())
+,final_balance_(initial_balance)
+,memory_budget_(memory_budget)
+,algorithm_(algorithm)
+,format_(format)
+{
+  if (boost::filesystem::exists(filename_)) BOOST_THROW_EXCEPTION(FileWriteError() << boost::errinfo_errno(EEXIST) << boost::errinfo_file_name(filename_.string()));
+
+  ArchivedListing::listing_type{ name }.format_to(std::back_inserter(header_));
+}
+
+io1::ArchiveWriter::~ArchiveWriter(void)
+{
+  for (auto const & run : runs_)
+  {
+    boost::system::error_code error;
+    boost::filesystem::remove(run, error);
+  }
+}
+
+// Formats the statement at the end of the buffer, which is spilled once it exceeds the memory budget.
+void io1::ArchiveWriter::add(Statement const & statement)
+{
+  auto const offset = buffer_.size();
+  statement.format_to(std::back_inserter(buffer_));
+
+  auto const day = ListingColumns::to_day(statement.main_entry().date());
+  records_.push_back({ day, offset, buffer_.size() - offset });
+  final_balance_ += statement.amount();
+  if (0 == count_ || final_day_ < day)
+  {
+    final_day_ = day;
+    final_date_ = statement.date();
+  }
+  ++count_;
+
+  if (memory_budget_ < buffer_.size() + records_.size() * sizeof(record_type)) spill();
+}
+
+// When everything fits in the budget, the buffer is written straight to the archive, otherwise the last buffer is spilled and all runs are merged.
+io1::ArchivedListing io1::ArchiveWriter::finish(void)
+{
+  assert(0 != count_);
+
+  Checksum checksum;
+  try
+  {
+    if (!runs_.empty() && !records_.empty()) spill();
+    checksum = runs_.empty() ? write_buffer() : merge_runs();
+  }
+  catch (...)
+  {
+    boost::system::error_code error;
+    boost::filesystem::remove(filename_, error); // no partial archive is left behind.
+    throw;
+  }
+
+  ArchivedListing archive;
+  archive.filename_ = filename_;
+  archive.final_date_ = final_date_;
+  archive.final_balance_ = final_balance_;
+  archive.checksum_ = std::move(checksum);
+
+  return archive;
+}
+
+void io1::ArchiveWriter::sort_buffer(void)
+{
+  std::stable_sort(records_.begin(), records_.end(), [](record_type const & lhs, record_type const & rhs) { return lhs.day < rhs.day; });
+}
+
+void io1::ArchiveWriter::spill(void)
+{
+  sort_buffer();
+
+  auto const run_filename = add_run();
+  boost::filesystem::ofstream run(run_filename, std::ios::binary);
+  for (auto const & record : records_) write_run_statement(run, record.day, std::string_view(buffer_).substr(record.offset, record.size));
+  if (!run.flush()) BOOST_THROW_EXCEPTION(FileWriteError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(run_filename.string()));
+
+  buffer_.clear();
+  records_.clear();
+}
+
+io1::Checksum io1::ArchiveWriter::write_buffer(void)
+{
+  sort_buffer();
+
+  return write_archive(filename_, algorithm_, format_, name_, header_, [this](auto write)
+  {
+    for (auto const & record : records_) write(std::string_view(buffer_).substr(record.offset, record.size));
+  });
+}
+
+io1::ArchiveWriter::path_type io1::ArchiveWriter::add_run(void)
+{
+  auto run_filename = filename_;
+  run_filename += ".run" + std::to_string(run_names_++);
+  runs_.push_back(run_filename); // registered first so that the destructor removes it whatever happens.
+
+  return run_filename;
+}
+
+// K-way merge of sorted runs. Statements of the same date are taken from the earliest run first, which keeps the merge stable.
+template<typename SINK> void io1::ArchiveWriter::merge(std::size_t first, std::size_t last, SINK sink) const
+{
+  std::deque<boost::filesystem::ifstream> runs;
+  std::vector<std::string> statements(last - first);
+  std::priority_queue<std::pair<day_type, std::size_t>, std::vector<std::pair<day_type, std::size_t>>, std::greater<>> next_runs; // day of the next statement of each run.
+
+  for (std::size_t run = 0; last - first > run; ++run)
+  {
+    runs.emplace_back(runs_[first + run], std::ios::binary);
+    if (!runs.back()) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(runs_[first + run].string()));
+
+    day_type day;
+    if (read_run_statement(runs.back(), runs_[first + run], day, statements[run])) next_runs.emplace(day, run);
+  }
+
+  while (!next_runs.empty())
+  {
+    auto const [day, run] = next_runs.top();
+    next_runs.pop();
+    sink(day, std::string_view(statements[run]));
+
+    day_type next_day;
+    if (read_run_statement(runs[run], runs_[first + run], next_day, statements[run])) next_runs.emplace(next_day, run);
+  }
+}
+
+// Groups of consecutive runs are merged in order, so that the merged runs keep the order of the statements of the same date.
+void io1::ArchiveWriter::merge_pass(void)
+{
+  auto const run_count = runs_.size();
+  for (std::size_t first = 0; run_count > first; first += max_merge_fan_in)
+  {
+    auto const run_filename = add_run();
+    boost::filesystem::ofstream run(run_filename, std::ios::binary);
+    merge(first, std::min(run_count, first + max_merge_fan_in), [&run](day_type day, std::string_view statement) { write_run_statement(run, day, statement); });
+    if (!run.flush()) BOOST_THROW_EXCEPTION(FileWriteError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(run_filename.string()));
+  }
+
+  for (std::size_t run = 0; run_count > run; ++run)
+  {
+    boost::system::error_code error;
+    boost::filesystem::remove(runs_[run], error);
+  }
+  runs_.erase(runs_.begin(), runs_.begin() + static_cast<std::ptrdiff_t>(run_count));
+
+  return;
+}
+
+// Passes merge the runs max_merge_fan_in at a time until they are few enough to be merged into the archive at once.
+io1::Checksum io1::ArchiveWriter::merge_runs(void)
+{
+  while (max_merge_fan_in < runs_.size()) merge_pass();
+
+  return write_archive(filename_, algorithm_, format_, name_, header_, [this](auto write)
+  {
+    merge(0, runs_.size(), [&write](day_type, std::string_view statement) { write(statement); });
+  });
+}
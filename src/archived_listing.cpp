@@ -1,4 +1,6 @@
 #include "archived_listing.hpp"
+#include <algorithm>
+#include <cassert>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/exception/errinfo_file_name.hpp>
@@ -7,115 +9,195 @@
 #include <boost/exception/errinfo_nested_exception.hpp>
 #include <boost/exception_ptr.hpp>
 #include <boost/format.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include "columnar_archive.hpp"
 #include "accounting_exception.hpp"
 #include "date_formatter.hpp"
-#include "sha1_sum.hpp"
-#include "sha1_sum_filter.hpp"
-#include "calculate_current_line.hpp"
 
-io1::ArchivedListing::ArchivedListing(path_type filename, QDate final_date, Money final_balance, std::string sha1)
+io1::ArchivedListing::ArchivedListing(path_type filename, QDate final_date, Money final_balance, Checksum checksum, verification_type verification)
 :filename_(std::move(filename))
 ,final_date_(std::move(final_date))
 ,final_balance_(final_balance)
-,sha1_(std::move(sha1))
+,checksum_(std::move(checksum))
 {
   if (!final_balance_.is_within_n_decimals<2>()) BOOST_THROW_EXCEPTION(InvalidAmountFormat() << InvalidAmountFormat::errinfo_amount{ final_balance_ });
   if (!final_date_.isValid()) BOOST_THROW_EXCEPTION(InvalidDate());
   if (!boost::filesystem::exists(filename_)) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(ENOENT) << boost::errinfo_file_name(filename_.string()));
   if (boost::filesystem::is_directory(filename_)) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(EISDIR) << boost::errinfo_file_name(filename_.string()));
 
-  auto const actual_sha1 = sha1_sum(filename_);
-  if (actual_sha1 != sha1_) BOOST_THROW_EXCEPTION(Sha1Mismatch() << Sha1Mismatch::errinfo_expected(sha1_) << Sha1Mismatch::errinfo_actual(actual_sha1));
+  if (verification_type::immediate == verification) verify();
 }
 
-io1::ArchivedListing::ArchivedListing(path_type filename, listing_type listing, QDate final_date, Money final_balance)
+io1::ArchivedListing::ArchivedListing(path_type filename, listing_type listing, QDate final_date, Money final_balance, HashAlgorithm algorithm, format_type format)
 :filename_(std::move(filename))
-,listing_(std::move(listing))
 ,final_date_(std::move(final_date))
 ,final_balance_(final_balance)
 {
   if (!final_balance_.is_within_n_decimals<2>()) BOOST_THROW_EXCEPTION(InvalidAmountFormat() << InvalidAmountFormat::errinfo_amount{ final_balance_ });
   if (!final_date_.isValid()) BOOST_THROW_EXCEPTION(InvalidDate());
 
-  (*listing_).stable_sort();
+  listing.stable_sort();
 
   if (boost::filesystem::exists(filename_)) BOOST_THROW_EXCEPTION(FileWriteError() << boost::errinfo_errno(EEXIST) << boost::errinfo_file_name(filename_.string()));
 
   {
+    // the file must outlive the chain, which flushes and closes it when destroyed.
+    boost::filesystem::ofstream file(filename_, (format_type::text != format) ? std::ios::out | std::ios::binary : std::ios::out);
+    if (!file) BOOST_THROW_EXCEPTION(FileWriteError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename_.string()));
+
     boost::iostreams::filtering_ostream out;
-    auto const filter = push<sha1_sum_filter>(out);
-    assert(filter);
+    ChecksumFilter const filter(algorithm);
 
+    out.push(filter);
+    out.push(file);
+    if (format_type::text != format)
     {
-      boost::filesystem::ofstream file(filename_);
-      if (!file) BOOST_THROW_EXCEPTION(FileWriteError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename_.string()));
-      out.push(file);
-      out << *listing_ << std::flush;
+      auto const encoding = (format_type::compressed == format) ? ColumnarArchiveWriter::encoding_type::compressed : ColumnarArchiveWriter::encoding_type::fixed;
+      ColumnarArchiveWriter writer(out, listing.name().toStdString(), algorithm, ColumnarArchiveWriter::default_block_size, encoding);
+      for (auto const & statement : listing.statements()) writer.add(statement);
+      writer.finish();
     }
+    else out << listing;
+    out << std::flush;
 
-    sha1_ = filter->read_sha1();
+    checksum_ = filter.checksum();
   }
+
+  load_state_->listing = share(std::move(listing));
+}
+
+// The first caller reads the file while the others wait for the result.
+io1::ArchivedListing::shared_listing_type io1::ArchivedListing::listing(void) const
+{
+  std::lock_guard const lock(load_state_->mutex);
+  if (!load_state_->listing) load_state_->listing = share(read_listing());
+
+  return load_state_->listing;
+}
+
+void io1::ArchivedListing::hold_listing(listing_type listing) const
+{
+  assert(listing.is_sorted());
+
+  auto shared_listing = share(std::move(listing));
+  std::lock_guard const lock(load_state_->mutex);
+  load_state_->listing = std::move(shared_listing);
+}
+
+// Shared listings are read from several threads at once, their const methods must not fill a cache meanwhile.
+io1::ArchivedListing::shared_listing_type io1::ArchivedListing::share(listing_type listing) const
+{
+  listing.build_caches(checksum_.algorithm());
+  return std::make_shared<listing_type const>(std::move(listing));
 }
 
-io1::ArchivedListing::listing_type const & io1::ArchivedListing::listing(void) const
+bool io1::ArchivedListing::is_loaded(void) const
 {
-  if (!listing_)
+  std::lock_guard const lock(load_state_->mutex);
+  return static_cast<bool>(load_state_->listing);
+}
+
+void io1::ArchivedListing::release_listing(void) const
+{
+  std::lock_guard const lock(load_state_->mutex);
+  load_state_->listing.reset();
+}
+
+void io1::ArchivedListing::verify(void) const
+{
+  auto const actual_checksum = file_checksum(checksum_.algorithm(), filename_);
+  if (actual_checksum != checksum_) BOOST_THROW_EXCEPTION(Sha1Mismatch() << Sha1Mismatch::errinfo_expected(checksum_.to_string()) << Sha1Mismatch::errinfo_actual(actual_checksum.to_string()));
+}
+
+// Archived listings are sorted by date, the range is found by binary search.
+std::vector<io1::Statement> io1::ArchivedListing::statements_between(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const
+{
+  auto const range = [&from, &to](listing_type const & listing)
   {
-    boost::filesystem::ifstream file{ filename_ };
-    if (!file) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename_.string()));
-    
-    boost::iostreams::filtering_istream in;
+    auto const first = std::partition_point(listing.begin(), listing.end(), [&from](Statement const & statement) { return statement.main_entry().date() < from; });
+    auto const last = std::partition_point(first, listing.end(), [&to](Statement const & statement) { return !(to < statement.main_entry().date()); });
+    return std::vector<Statement>(first, last);
+  };
 
-    auto const filter = push<sha1_sum_filter>(in);
-    assert(filter);
-    
-    in.push(file);
+  {
+    std::lock_guard const lock(load_state_->mutex);
+    if (load_state_->listing) return range(*load_state_->listing);
+  }
 
-    try
-    {
-      try
-      {
-        listing_ = listing_type::read(in);
-        auto const actual_sha1 = filter->read_sha1();
-
-        if (sha1_ != actual_sha1) BOOST_THROW_EXCEPTION(Sha1Mismatch() << Sha1Mismatch::errinfo_expected(sha1_) << Sha1Mismatch::errinfo_actual(actual_sha1));
-      }
-      catch (ParseError & e)
-      {
-        e << ParseError::errinfo_line_number(calculate_current_line(file));
-        throw;
-      }
-    }
-    catch(...)
-    {
-      BOOST_THROW_EXCEPTION(CorruptedFile{} << boost::errinfo_file_name(filename_.string()) << boost::errinfo_nested_exception(boost::current_exception()));
-    }
+  boost::iostreams::mapped_file_source file;
+  try
+  {
+    file.open(filename_.string());
   }
+  catch (std::ios_base::failure const &)
+  {
+    BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename_.string()));
+  }
+
+  std::string_view const content{ file.data(), file.size() };
+  if (!ColumnarArchive::is_columnar(content)) return range(read_listing());
+
+  try
+  {
+    return ColumnarArchive(content).statements_between(from, to);
+  }
+  catch(...)
+  {
+    BOOST_THROW_EXCEPTION(CorruptedFile{} << boost::errinfo_file_name(filename_.string()) << boost::errinfo_nested_exception(boost::current_exception()));
+  }
+}
 
-  return *listing_;
+// The file is mapped in memory, hashed as a whole and then parsed in place, or decoded if it is columnar.
+io1::ArchivedListing::listing_type io1::ArchivedListing::read_listing(void) const
+{
+  boost::iostreams::mapped_file_source file;
+  try
+  {
+    file.open(filename_.string());
+  }
+  catch (std::ios_base::failure const &)
+  {
+    BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename_.string()));
+  }
+
+  try
+  {
+    std::string_view const content{ file.data(), file.size() };
+
+    auto const actual_checksum = io1::checksum(checksum_.algorithm(), content);
+    if (checksum_ != actual_checksum) BOOST_THROW_EXCEPTION(Sha1Mismatch() << Sha1Mismatch::errinfo_expected(checksum_.to_string()) << Sha1Mismatch::errinfo_actual(actual_checksum.to_string()));
+
+    if (ColumnarArchive::is_columnar(content)) return ColumnarArchive(content).listing();
+    return listing_type::read(content);
+  }
+  catch(...)
+  {
+    BOOST_THROW_EXCEPTION(CorruptedFile{} << boost::errinfo_file_name(filename_.string()) << boost::errinfo_nested_exception(boost::current_exception()));
+  }
 }
 
 std::ostream & io1::ArchivedListing::write(std::ostream & stream) const
 {
-  stream << boost::format("%1% %2$_#15.2f%\t%3% %4%") % date_formatter(final_date_) % final_balance_ % sha1_ % filename_;
+  stream << boost::format("%1% %2$_#15.2f\t%3% %4%") % date_formatter(final_date_) % final_balance_ % checksum_ % filename_;
   return stream;
 }
 
-io1::ArchivedListing io1::ArchivedListing::read(std::istream & stream)
+io1::ArchivedListing io1::ArchivedListing::read(std::istream & stream, verification_type verification)
 {
   Money balance;
   QDate date;
   path_type filename;
-  std::string sha1;
+  Checksum checksum;
 
   stream >> std::ws >> date;
   stream >> balance;
-  stream >> sha1;
+  stream >> checksum;
   stream >> filename;
 
   if (!stream) BOOST_THROW_EXCEPTION(ParseError() << ParseError::errinfo_class_name("Archived Listing"));
 
-  return ArchivedListing{std::move(filename),std::move(date),std::move(balance),std::move(sha1)};
+  return ArchivedListing{std::move(filename),std::move(date),std::move(balance),std::move(checksum),verification};
 }
 
 std::ostream & io1::operator<<(std::ostream & stream, ArchivedListing const & archive)
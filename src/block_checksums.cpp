@@ -0,0 +1,134 @@
+#include "block_checksums.hpp"
+#include <algorithm>
+#include <cassert>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <boost/throw_exception.hpp>
+#include "accounting_exception.hpp"
+
+io1::BlockChecksums::BlockChecksums(HashAlgorithm algorithm, std::size_t block_size)
+:algorithm_(algorithm)
+,block_size_(block_size)
+{
+  assert(0 != block_size_);
+}
+
+io1::Checksum io1::BlockChecksums::root(void) const
+{
+  std::ostringstream index;
+  write(index);
+  return checksum(algorithm_, index.view());
+}
+
+// Edits that shift statements drop every block from the first one they touch, resize adds them back as stale blocks.
+void io1::BlockChecksums::invalidate(std::size_t first, std::size_t last)
+{
+  if (first >= last) return;
+
+  auto const first_block = first / block_size_;
+  if (first_block >= blocks_.size()) return;
+
+  if (std::numeric_limits<std::size_t>::max() == last) blocks_.resize(first_block + 1);
+  auto const last_block = std::min(blocks_.size(), (last - 1) / block_size_ + 1);
+  for (auto block = first_block; last_block > block; ++block) blocks_[block].checksum = Checksum();
+
+  return;
+}
+
+// There is always a block, the one of the title.
+void io1::BlockChecksums::resize(std::size_t statement_count)
+{
+  blocks_.resize(std::max<std::size_t>(1, (statement_count + block_size_ - 1) / block_size_));
+  for (std::size_t block = 0; blocks_.size() > block; ++block)
+  {
+    auto const count = std::min(block_size_, statement_count - std::min(statement_count, first_statement(block)));
+    if (count != blocks_[block].statement_count)
+    {
+      blocks_[block].statement_count = count;
+      blocks_[block].checksum = Checksum();
+    }
+  }
+
+  return;
+}
+
+bool io1::BlockChecksums::is_up_to_date(std::size_t statement_count) const
+{
+  if (std::max<std::size_t>(1, (statement_count + block_size_ - 1) / block_size_) != blocks_.size()) return false;
+  for (std::size_t block = 0; blocks_.size() > block; ++block)
+  {
+    if (is_stale(block) || std::min(block_size_, statement_count - std::min(statement_count, first_statement(block))) != blocks_[block].statement_count) return false;
+  }
+
+  return true;
+}
+
+void io1::BlockChecksums::set_block(std::size_t block, std::string_view bytes)
+{
+  blocks_[block].byte_count = bytes.size();
+  blocks_[block].checksum = checksum(algorithm_, bytes);
+}
+
+// The last block is given whatever follows the others, so that a longer file fails on it, and a shorter one on the block it ends in.
+void io1::BlockChecksums::verify(std::string_view bytes) const
+{
+  std::size_t offset = 0;
+  for (std::size_t block = 0; blocks_.size() > block; ++block)
+  {
+    auto const byte_count = (blocks_.size() == block + 1) ? std::string_view::npos : blocks_[block].byte_count;
+    auto const actual_checksum = checksum(algorithm_, bytes.substr(std::min(offset, bytes.size()), byte_count));
+    if (blocks_[block].checksum != actual_checksum)
+      BOOST_THROW_EXCEPTION(Sha1Mismatch() << errinfo_block_index(block) << Sha1Mismatch::errinfo_expected(blocks_[block].checksum.to_string()) << Sha1Mismatch::errinfo_actual(actual_checksum.to_string()));
+
+    offset += blocks_[block].byte_count;
+  }
+
+  return;
+}
+
+// The first line holds the algorithm, the block size and the block count, then each block has a line of its own.
+std::ostream & io1::BlockChecksums::write(std::ostream & stream) const
+{
+  stream << to_string(algorithm_) << ' ' << block_size_ << ' ' << blocks_.size() << '\n';
+  for (auto const & block : blocks_)
+  {
+    assert(!block.checksum.digest().empty());
+    stream << block.statement_count << ' ' << block.byte_count << ' ' << block.checksum << '\n';
+  }
+
+  return stream;
+}
+
+io1::BlockChecksums io1::BlockChecksums::read(std::istream & stream)
+{
+  auto const parse_error = [] { BOOST_THROW_EXCEPTION(ParseError() << ParseError::errinfo_class_name("BlockChecksums")); };
+
+  std::string algorithm;
+  std::size_t block_size = 0;
+  std::size_t block_count = 0;
+  if (!(stream >> algorithm >> block_size >> block_count) || 0 == block_size || 0 == block_count) parse_error();
+
+  BlockChecksums checksums(HashAlgorithm::sha1, block_size);
+  if (to_string(HashAlgorithm::xxh64) == algorithm) checksums.algorithm_ = HashAlgorithm::xxh64;
+  else if (to_string(HashAlgorithm::sha1) != algorithm) parse_error();
+
+  checksums.blocks_.resize(block_count);
+  for (auto & block : checksums.blocks_)
+  {
+    if (!(stream >> block.statement_count >> block.byte_count >> block.checksum) || block.checksum.algorithm() != checksums.algorithm_) parse_error();
+  }
+
+  return checksums;
+}
+
+std::ostream & io1::operator<<(std::ostream & stream, BlockChecksums const & checksums)
+{
+  return checksums.write(stream);
+}
+
+std::istream & io1::operator>>(std::istream & stream, BlockChecksums & checksums)
+{
+  checksums = BlockChecksums::read(stream);
+  return stream;
+}
@@ -0,0 +1,450 @@
+#include "checksum.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/throw_exception.hpp>
+#include "accounting_exception.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IO1_SHA1_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define IO1_TARGET_SHA
+#else
+#include <cpuid.h>
+#define IO1_TARGET_SHA __attribute__((target("sha,sse4.1")))
+#endif
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+// the intrinsics are only available when the compiler targets the cryptographic extension, as it does by default on Apple silicon.
+#define IO1_SHA1_ARM
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+namespace
+{
+  auto const hex_digits = "0123456789abcdef";
+  std::size_t const sha1_digest_size = 40;
+  std::size_t const xxh64_digest_size = 16;
+
+  std::uint32_t load_be32(unsigned char const * p)
+  {
+    return (std::uint32_t{ p[0] } << 24) | (std::uint32_t{ p[1] } << 16) | (std::uint32_t{ p[2] } << 8) | std::uint32_t{ p[3] };
+  }
+
+  template<typename T> T load_le(unsigned char const * p)
+  {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    if constexpr (std::endian::big == std::endian::native)
+    {
+      T swapped = 0;
+      for (std::size_t i = 0; sizeof(T) > i; ++i) swapped |= T{ p[i] } << (8 * i);
+      value = swapped;
+    }
+    return value;
+  }
+
+  // Appends value as big endian hexadecimal digits.
+  template<typename T> void append_hex(std::string & digest, T value)
+  {
+    for (int shift = 8 * sizeof(T) - 4; 0 <= shift; shift -= 4) digest += hex_digits[(value >> shift) & 0xF];
+  }
+
+  // SHA-1 compression of whole 64 byte blocks, as specified by FIPS 180-4. The message schedule is kept in a rolling window of 16 words.
+  void sha1_compress_portable(std::uint32_t * h, unsigned char const * data, std::size_t block_count)
+  {
+    for (; 0 != block_count; --block_count, data += 64)
+    {
+      std::uint32_t w[16];
+      for (int i = 0; 16 > i; ++i) w[i] = load_be32(data + 4 * i);
+
+      auto a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+      auto const round = [&](int i, std::uint32_t f, std::uint32_t k)
+      {
+        if (16 <= i) w[i & 15] = std::rotl(w[(i - 3) & 15] ^ w[(i - 8) & 15] ^ w[(i - 14) & 15] ^ w[i & 15], 1);
+
+        auto const temp = std::rotl(a, 5) + f + e + k + w[i & 15];
+        e = d;
+        d = c;
+        c = std::rotl(b, 30);
+        b = a;
+        a = temp;
+      };
+
+      for (int i = 0; 20 > i; ++i) round(i, d ^ (b & (c ^ d)), 0x5A827999);
+      for (int i = 20; 40 > i; ++i) round(i, b ^ c ^ d, 0x6ED9EBA1);
+      for (int i = 40; 60 > i; ++i) round(i, (b & c) | (d & (b | c)), 0x8F1BBCDC);
+      for (int i = 60; 80 > i; ++i) round(i, b ^ c ^ d, 0xCA62C1D6);
+
+      h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+  }
+
+#if defined(IO1_SHA1_X86)
+  bool cpu_has_sha(void)
+  {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int registers[4];
+    __cpuid(registers, 0);
+    if (7 > registers[0]) return false;
+    __cpuidex(registers, 1, 0);
+    bool const sse41 = 0 != (registers[2] & (1 << 19));
+    __cpuidex(registers, 7, 0);
+    return sse41 && 0 != (registers[1] & (1 << 29));
+#else
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || 0 == (ecx & bit_SSE4_1)) return false;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    return 0 != (ebx & bit_SHA);
+#endif
+  }
+
+  // Each group of four rounds is one sha1rnds4, the message schedule is computed four words at a time by sha1msg1 and sha1msg2.
+  IO1_TARGET_SHA void sha1_compress_accelerated(std::uint32_t * h, unsigned char const * data, std::size_t block_count)
+  {
+    __m128i const byte_swap = _mm_set_epi64x(0x0001020304050607, 0x08090a0b0c0d0e0f);
+
+    auto abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(h)), 0x1B);
+    auto e0 = _mm_set_epi32(static_cast<int>(h[4]), 0, 0, 0);
+
+    for (; 0 != block_count; --block_count, data += 64)
+    {
+      auto const abcd_saved = abcd;
+      auto const e0_saved = e0;
+
+      __m128i w[20];
+      for (int i = 0; 4 > i; ++i) w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(data + 16 * i)), byte_swap);
+      for (int i = 4; 20 > i; ++i) w[i] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[i - 4], w[i - 3]), w[i - 2]), w[i - 1]);
+
+      // e holds e plus the message words of the next four rounds, previous_abcd the state before the last group, from which sha1nexte derives e.
+      auto e = _mm_add_epi32(e0, w[0]);
+      auto previous_abcd = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+      for (int i = 1; 5 > i; ++i) { e = _mm_sha1nexte_epu32(previous_abcd, w[i]); previous_abcd = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 0); }
+      for (int i = 5; 10 > i; ++i) { e = _mm_sha1nexte_epu32(previous_abcd, w[i]); previous_abcd = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 1); }
+      for (int i = 10; 15 > i; ++i) { e = _mm_sha1nexte_epu32(previous_abcd, w[i]); previous_abcd = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 2); }
+      for (int i = 15; 20 > i; ++i) { e = _mm_sha1nexte_epu32(previous_abcd, w[i]); previous_abcd = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 3); }
+
+      e0 = _mm_sha1nexte_epu32(previous_abcd, e0_saved);
+      abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(h), _mm_shuffle_epi32(abcd, 0x1B));
+    h[4] = static_cast<std::uint32_t>(_mm_extract_epi32(e0, 3));
+  }
+#elif defined(IO1_SHA1_ARM)
+  bool cpu_has_sha(void)
+  {
+#if defined(__linux__)
+    return 0 != (getauxval(AT_HWCAP) & HWCAP_SHA1);
+#else
+    return true;
+#endif
+  }
+
+  // Each group of four rounds is one sha1c, sha1p or sha1m, the message schedule is computed four words at a time by sha1su0 and sha1su1.
+  void sha1_compress_accelerated(std::uint32_t * h, unsigned char const * data, std::size_t block_count)
+  {
+    uint32x4_t const k[4] = { vdupq_n_u32(0x5A827999), vdupq_n_u32(0x6ED9EBA1), vdupq_n_u32(0x8F1BBCDC), vdupq_n_u32(0xCA62C1D6) };
+
+    auto abcd = vld1q_u32(h);
+    auto e0 = h[4];
+
+    for (; 0 != block_count; --block_count, data += 64)
+    {
+      auto const abcd_saved = abcd;
+      auto const e0_saved = e0;
+
+      uint32x4_t w[20];
+      for (int i = 0; 4 > i; ++i) w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+      for (int i = 4; 20 > i; ++i) w[i] = vsha1su1q_u32(vsha1su0q_u32(w[i - 4], w[i - 3], w[i - 2]), w[i - 1]);
+
+      auto e = e0;
+      for (int i = 0; 20 > i; ++i)
+      {
+        auto const next_e = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+        auto const wk = vaddq_u32(w[i], k[i / 5]);
+        switch (i / 5)
+        {
+        case 0: abcd = vsha1cq_u32(abcd, e, wk); break;
+        case 2: abcd = vsha1mq_u32(abcd, e, wk); break;
+        default: abcd = vsha1pq_u32(abcd, e, wk); break;
+        }
+        e = next_e;
+      }
+
+      e0 = e + e0_saved;
+      abcd = vaddq_u32(abcd, abcd_saved);
+    }
+
+    vst1q_u32(h, abcd);
+    h[4] = e0;
+  }
+#endif
+
+  using sha1_compress_type = void (*)(std::uint32_t *, unsigned char const *, std::size_t);
+
+  bool has_sha_instructions(void)
+  {
+#if defined(IO1_SHA1_X86) || defined(IO1_SHA1_ARM)
+    static bool const has_sha = cpu_has_sha();
+    return has_sha;
+#else
+    return false;
+#endif
+  }
+
+  // The compression in use, chosen on first use from what the CPU supports.
+  sha1_compress_type & sha1_compress(void)
+  {
+#if defined(IO1_SHA1_X86) || defined(IO1_SHA1_ARM)
+    static sha1_compress_type compress = has_sha_instructions() ? sha1_compress_accelerated : sha1_compress_portable;
+#else
+    static sha1_compress_type compress = sha1_compress_portable;
+#endif
+    return compress;
+  }
+
+  // Hashes bytes with a whole block compression: the pending bytes are completed into a block first, then whole blocks are hashed
+  // straight from the input and what remains is kept pending. length counts the bytes hashed so far, pending ones included.
+  template<std::size_t N, typename COMPRESS> void update_blocks(std::array<unsigned char, N> & pending, std::uint64_t & length, std::string_view bytes, COMPRESS compress)
+  {
+    auto data = reinterpret_cast<unsigned char const *>(bytes.data());
+    auto size = bytes.size();
+    auto const pending_size = static_cast<std::size_t>(length % N);
+    length += size;
+
+    if (0 != pending_size)
+    {
+      auto const count = std::min(N - pending_size, size);
+      std::memcpy(pending.data() + pending_size, data, count);
+      if (N != pending_size + count) return;
+
+      compress(pending.data(), 1);
+      data += count;
+      size -= count;
+    }
+
+    compress(data, size / N);
+    if (0 != size % N) std::memcpy(pending.data(), data + size / N * N, size % N);
+  }
+
+  std::uint64_t const xxh64_prime1 = 0x9E3779B185EBCA87;
+  std::uint64_t const xxh64_prime2 = 0xC2B2AE3D27D4EB4F;
+  std::uint64_t const xxh64_prime3 = 0x165667B19E3779F9;
+  std::uint64_t const xxh64_prime4 = 0x85EBCA77C2B2AE63;
+  std::uint64_t const xxh64_prime5 = 0x27D4EB2F165667C5;
+
+  std::uint64_t xxh64_round(std::uint64_t accumulator, std::uint64_t input)
+  {
+    return std::rotl(accumulator + input * xxh64_prime2, 31) * xxh64_prime1;
+  }
+
+  std::uint64_t xxh64_merge_round(std::uint64_t accumulator, std::uint64_t value)
+  {
+    return (accumulator ^ xxh64_round(0, value)) * xxh64_prime1 + xxh64_prime4;
+  }
+
+  // Consumes whole 32 byte stripes, one 8 byte lane per accumulator.
+  void xxh64_consume(std::array<std::uint64_t, 4> & v, unsigned char const * data, std::size_t stripe_count)
+  {
+    auto v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+    for (; 0 != stripe_count; --stripe_count, data += 32)
+    {
+      v0 = xxh64_round(v0, load_le<std::uint64_t>(data));
+      v1 = xxh64_round(v1, load_le<std::uint64_t>(data + 8));
+      v2 = xxh64_round(v2, load_le<std::uint64_t>(data + 16));
+      v3 = xxh64_round(v3, load_le<std::uint64_t>(data + 24));
+    }
+    v = { v0, v1, v2, v3 };
+  }
+}
+
+io1::Checksum::Checksum(HashAlgorithm algorithm, std::string digest)
+:algorithm_(algorithm)
+,digest_(std::move(digest))
+{
+}
+
+std::string io1::Checksum::to_string(void) const
+{
+  return std::string(io1::to_string(algorithm_)) + ':' + digest_;
+}
+
+// A bare digest of 40 hexadecimal digits is a SHA-1 written before algorithms were recorded.
+bool io1::Checksum::parse(std::string_view text, Checksum & checksum) noexcept
+{
+  auto const is_digest = [](std::string_view digest, std::size_t size) { return size == digest.size() && std::string_view::npos == digest.find_first_not_of(hex_digits); };
+
+  HashAlgorithm algorithm = HashAlgorithm::sha1;
+  auto digest = text;
+  if (auto const separator = text.find(':'); std::string_view::npos != separator)
+  {
+    auto const name = text.substr(0, separator);
+    if (io1::to_string(HashAlgorithm::sha1) == name) algorithm = HashAlgorithm::sha1;
+    else if (io1::to_string(HashAlgorithm::xxh64) == name) algorithm = HashAlgorithm::xxh64;
+    else return false;
+
+    digest = text.substr(separator + 1);
+  }
+
+  if (!is_digest(digest, (HashAlgorithm::sha1 == algorithm) ? sha1_digest_size : xxh64_digest_size)) return false;
+
+  try
+  {
+    checksum = Checksum(algorithm, std::string(digest));
+  }
+  catch (...)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+std::ostream & io1::operator<<(std::ostream & stream, Checksum const & checksum)
+{
+  return stream << checksum.to_string();
+}
+
+std::istream & io1::operator>>(std::istream & stream, Checksum & checksum)
+{
+  std::string text;
+  if ((stream >> text) && !Checksum::parse(text, checksum)) BOOST_THROW_EXCEPTION(ParseError() << ParseError::errinfo_class_name("Checksum"));
+
+  return stream;
+}
+
+std::string_view io1::to_string(HashAlgorithm algorithm)
+{
+  return (HashAlgorithm::xxh64 == algorithm) ? "xxh64" : "sha1";
+}
+
+io1::Hasher::Hasher(HashAlgorithm algorithm)
+{
+  if (HashAlgorithm::xxh64 == algorithm) state_ = detail::xxh64_state{};
+}
+
+io1::HashAlgorithm io1::Hasher::algorithm(void) const
+{
+  return std::holds_alternative<detail::xxh64_state>(state_) ? HashAlgorithm::xxh64 : HashAlgorithm::sha1;
+}
+
+io1::Hasher & io1::Hasher::update(std::string_view bytes)
+{
+  if (auto const sha1 = std::get_if<detail::sha1_state>(&state_))
+    update_blocks(sha1->block, sha1->length, bytes, [h = sha1->h.data()](unsigned char const * data, std::size_t count) { if (0 != count) sha1_compress()(h, data, count); });
+  else
+  {
+    auto & xxh64 = std::get<detail::xxh64_state>(state_);
+    update_blocks(xxh64.stripe, xxh64.length, bytes, [&v = xxh64.v](unsigned char const * data, std::size_t count) { xxh64_consume(v, data, count); });
+  }
+
+  return *this;
+}
+
+// Finalization works on a copy of the state, so that hashing can go on.
+io1::Checksum io1::Hasher::checksum(void) const
+{
+  std::string digest;
+  if (auto const sha1 = std::get_if<detail::sha1_state>(&state_))
+  {
+    auto state = *sha1;
+    auto const bit_length = state.length * 8;
+
+    // the message is padded with a one bit, zeros and its length in bits, up to a whole number of blocks.
+    std::array<unsigned char, 72> padding{ 0x80 };
+    auto const padding_size = ((55 - state.length % 64) % 64) + 1;
+    for (int i = 0; 8 > i; ++i) padding[padding_size + i] = static_cast<unsigned char>(bit_length >> (56 - 8 * i));
+
+    update_blocks(state.block, state.length, { reinterpret_cast<char const *>(padding.data()), padding_size + 8 }, [h = state.h.data()](unsigned char const * data, std::size_t count) { if (0 != count) sha1_compress()(h, data, count); });
+    for (auto const word : state.h) append_hex(digest, word);
+  }
+  else
+  {
+    auto const & state = std::get<detail::xxh64_state>(state_);
+    auto const & v = state.v;
+
+    std::uint64_t h;
+    if (32 <= state.length)
+    {
+      h = std::rotl(v[0], 1) + std::rotl(v[1], 7) + std::rotl(v[2], 12) + std::rotl(v[3], 18);
+      for (auto const lane : v) h = xxh64_merge_round(h, lane);
+    }
+    else h = xxh64_prime5;
+    h += state.length;
+
+    auto p = state.stripe.data();
+    auto remaining = static_cast<std::size_t>(state.length % 32);
+    for (; 8 <= remaining; remaining -= 8, p += 8) h = std::rotl(h ^ xxh64_round(0, load_le<std::uint64_t>(p)), 27) * xxh64_prime1 + xxh64_prime4;
+    if (4 <= remaining)
+    {
+      h = std::rotl(h ^ (load_le<std::uint32_t>(p) * xxh64_prime1), 23) * xxh64_prime2 + xxh64_prime3;
+      remaining -= 4;
+      p += 4;
+    }
+    for (; 0 != remaining; --remaining, ++p) h = std::rotl(h ^ (*p * xxh64_prime5), 11) * xxh64_prime1;
+
+    h ^= h >> 33;
+    h *= xxh64_prime2;
+    h ^= h >> 29;
+    h *= xxh64_prime3;
+    h ^= h >> 32;
+    append_hex(digest, h);
+  }
+
+  return Checksum(algorithm(), std::move(digest));
+}
+
+io1::Checksum io1::checksum(HashAlgorithm algorithm, std::string_view bytes)
+{
+  return Hasher(algorithm).update(bytes).checksum();
+}
+
+// Mapping the file avoids copying it through stream buffers. Empty files cannot be mapped.
+io1::Checksum io1::file_checksum(HashAlgorithm algorithm, boost::filesystem::path const & filename)
+{
+  boost::system::error_code error;
+  auto const size = boost::filesystem::file_size(filename, error);
+  if (error) BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(error.value()) << boost::errinfo_file_name(filename.string()));
+  if (0 == size) return checksum(algorithm, std::string_view());
+
+  boost::iostreams::mapped_file_source file;
+  try
+  {
+    file.open(filename.string());
+  }
+  catch (std::ios_base::failure const &)
+  {
+    BOOST_THROW_EXCEPTION(FileReadError() << boost::errinfo_errno(errno) << boost::errinfo_file_name(filename.string()));
+  }
+
+  return checksum(algorithm, std::string_view(file.data(), file.size()));
+}
+
+bool io1::sha1_acceleration(void)
+{
+  return sha1_compress_portable != sha1_compress();
+}
+
+void io1::set_sha1_acceleration(bool enabled)
+{
+#if defined(IO1_SHA1_X86) || defined(IO1_SHA1_ARM)
+  sha1_compress() = (enabled && has_sha_instructions()) ? sha1_compress_accelerated : sha1_compress_portable;
+#else
+  (void)enabled;
+#endif
+  return;
+}
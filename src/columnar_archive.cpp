@@ -0,0 +1,451 @@
+#include "columnar_archive.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <boost/range/iterator_range.hpp>
+#include <boost/throw_exception.hpp>
+#include "block_checksums.hpp"
+#include "accounting_exception.hpp"
+
+namespace
+{
+  // Starts and ends the files, its first byte cannot start a text listing. The last byte is the encoding of the blocks.
+  constexpr std::string_view fixed_magic{ "\x89IO1COL\x01", 8 };
+  constexpr std::string_view compressed_magic{ "\x89IO1COL\x02", 8 };
+  constexpr std::size_t magic_size = fixed_magic.size();
+
+  std::string_view magic(io1::ColumnarArchiveWriter::encoding_type encoding)
+  {
+    return (io1::ColumnarArchiveWriter::encoding_type::compressed == encoding) ? compressed_magic : fixed_magic;
+  }
+
+  // Footer, then the trailer: footer digest | algorithm (u32) | footer size (u64) | magic.
+  constexpr std::size_t trailer_size = 4 + 8 + magic_size; // digest excepted.
+
+  std::size_t digest_length(io1::HashAlgorithm algorithm)
+  {
+    return (io1::HashAlgorithm::xxh64 == algorithm) ? 16 : 40;
+  }
+
+  // Integers are stored little endian whatever the platform.
+  template<typename T> void append(std::string & bytes, T value)
+  {
+    auto const bits = static_cast<std::make_unsigned_t<T>>(value);
+    for (std::size_t i = 0; sizeof(T) > i; ++i) bytes.push_back(static_cast<char>(bits >> (8 * i)));
+  }
+
+  template<typename T> void append_column(std::string & bytes, std::vector<T> const & column)
+  {
+    if constexpr (std::endian::little == std::endian::native) bytes.append(reinterpret_cast<char const *>(column.data()), column.size() * sizeof(T));
+    else for (auto const value : column) append(bytes, value);
+  }
+
+  // Variable length integers take 7 bits a byte, every byte but the last has its high bit set.
+  void append_varint(std::string & bytes, std::uint64_t value)
+  {
+    for (; 0x80 <= value; value >>= 7) bytes.push_back(static_cast<char>(value | 0x80));
+    bytes.push_back(static_cast<char>(value));
+  }
+
+  // Zig-zag encoding interleaves signed integers so that small magnitudes make small varints: 0, -1, 1, -2... become 0, 1, 2, 3...
+  std::uint64_t zigzag(std::int64_t value)
+  {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+  }
+
+  std::int64_t unzigzag(std::uint64_t value)
+  {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+  }
+
+  // Reads an integer at offset, which the caller checked is within bytes. Compiles to a single unaligned load on little endian platforms.
+  template<typename T> T load(std::string_view bytes, std::size_t offset)
+  {
+    std::make_unsigned_t<T> bits = 0;
+    if constexpr (std::endian::little == std::endian::native) std::memcpy(&bits, bytes.data() + offset, sizeof(T));
+    else for (std::size_t i = 0; sizeof(T) > i; ++i) bits |= static_cast<std::make_unsigned_t<T>>(static_cast<unsigned char>(bytes[offset + i])) << (8 * i);
+    return static_cast<T>(bits);
+  }
+
+  [[noreturn]] void throw_corrupted(void)
+  {
+    BOOST_THROW_EXCEPTION(io1::CorruptedFile());
+  }
+
+  // Reads the fields of the footer or of a compressed block one after the other, checking that each one is within it.
+  class ByteReader
+  {
+  public:
+    explicit ByteReader(std::string_view bytes) :bytes_(bytes) {};
+
+    template<typename T> T take(void)
+    {
+      if (sizeof(T) > bytes_.size() - offset_) throw_corrupted();
+      auto const value = load<T>(bytes_, offset_);
+      offset_ += sizeof(T);
+      return value;
+    };
+
+    std::string_view take(std::uint64_t size)
+    {
+      if (size > bytes_.size() - offset_) throw_corrupted();
+      auto const bytes = bytes_.substr(offset_, static_cast<std::size_t>(size));
+      offset_ += static_cast<std::size_t>(size);
+      return bytes;
+    };
+
+    std::uint64_t take_varint(void)
+    {
+      std::uint64_t value = 0;
+      for (unsigned shift = 0; 64 > shift; shift += 7)
+      {
+        if (bytes_.size() == offset_) throw_corrupted();
+        auto const byte = static_cast<unsigned char>(bytes_[offset_++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (0 == (byte & 0x80)) return value;
+      }
+      throw_corrupted();
+    };
+
+    bool done(void) const { return bytes_.size() == offset_; };
+
+  private:
+    std::string_view bytes_;
+    std::size_t offset_{ 0 };
+  };
+
+  io1::Checksum parse_digest(io1::HashAlgorithm algorithm, std::string_view digest)
+  {
+    io1::Checksum checksum;
+    if (!io1::Checksum::parse(std::string(to_string(algorithm)) + ':' + std::string(digest), checksum)) throw_corrupted();
+    return checksum;
+  }
+
+  void add_statement(std::vector<io1::Entry> & entries, std::vector<io1::Statement> & statements)
+  {
+    if (1 == entries.size()) statements.emplace_back(std::move(entries.front()));
+    else statements.emplace_back(std::span<io1::Entry const>(entries));
+  }
+
+  // Each entry is read straight from its columns, only its description is copied.
+  void decode_fixed(std::string_view data, std::size_t statement_count, std::size_t entry_count, std::vector<io1::Statement> & statements)
+  {
+    using day_type = io1::ListingColumns::day_type;
+    if (data.size() / 16 < entry_count || (data.size() - 16 * entry_count) / 4 < statement_count) throw_corrupted();
+
+    auto const days = 8 * entry_count;
+    auto const entry_counts = 12 * entry_count;
+    auto const description_ends = entry_counts + 4 * statement_count;
+    auto const descriptions = data.substr(description_ends + 4 * entry_count);
+
+    std::vector<io1::Entry> entries;
+    std::size_t entry = 0;
+    std::uint32_t description_begin = 0;
+    for (std::size_t statement = 0; statement_count > statement; ++statement)
+    {
+      auto const count = load<std::uint32_t>(data, entry_counts + 4 * statement);
+      if (0 == count || entry_count - entry < count) throw_corrupted();
+
+      entries.clear();
+      for (auto const last = entry + count; last > entry; ++entry)
+      {
+        auto const description_end = load<std::uint32_t>(data, description_ends + 4 * entry);
+        if (description_end < description_begin || descriptions.size() < description_end) throw_corrupted();
+
+        entries.emplace_back(io1::Money{ load<std::int64_t>(data, 8 * entry) }, std::string(descriptions.substr(description_begin, description_end - description_begin)), io1::ListingColumns::to_date(load<day_type>(data, days + 4 * entry)));
+        description_begin = description_end;
+      }
+      add_statement(entries, statements);
+    }
+    if (entry_count != entry) throw_corrupted();
+  }
+
+  // The block is read front to back: the descriptions of the dictionary are referred to in place, then each entry is decoded
+  // as its varints are read.
+  void decode_compressed(std::string_view data, std::size_t statement_count, std::size_t entry_count, std::vector<io1::Statement> & statements)
+  {
+    using day_type = io1::ListingColumns::day_type;
+    ByteReader reader(data);
+
+    auto const dictionary_size = reader.take_varint();
+    if (data.size() < dictionary_size) throw_corrupted(); // each description takes a byte at least.
+    std::vector<std::string_view> dictionary;
+    dictionary.reserve(static_cast<std::size_t>(dictionary_size));
+    for (std::uint64_t i = 0; dictionary_size > i; ++i) dictionary.push_back(reader.take(reader.take_varint()));
+
+    std::vector<io1::Entry> entries;
+    std::size_t entry = 0;
+    std::int64_t day = 0;
+    for (std::size_t statement = 0; statement_count > statement; ++statement)
+    {
+      auto const count = reader.take_varint();
+      if (0 == count || entry_count - entry < count) throw_corrupted();
+
+      entries.clear();
+      for (auto const last = entry + count; last > entry; ++entry)
+      {
+        auto const day_delta = unzigzag(reader.take_varint());
+        if (std::numeric_limits<day_type>::min() - day > day_delta || std::numeric_limits<day_type>::max() - day < day_delta) throw_corrupted();
+        day += day_delta;
+
+        auto const amount = unzigzag(reader.take_varint());
+        auto const description = reader.take_varint();
+        if (dictionary.size() <= description) throw_corrupted();
+
+        entries.emplace_back(io1::Money{ amount }, std::string(dictionary[static_cast<std::size_t>(description)]), io1::ListingColumns::to_date(static_cast<day_type>(day)));
+      }
+      add_statement(entries, statements);
+    }
+    if (entry_count != entry || !reader.done()) throw_corrupted();
+  }
+}
+
+io1::ColumnarArchiveWriter::ColumnarArchiveWriter(std::ostream & stream, std::string name, HashAlgorithm algorithm, std::size_t block_size, encoding_type encoding)
+:stream_(stream)
+,name_(std::move(name))
+,algorithm_(algorithm)
+,block_size_(block_size)
+,encoding_(encoding)
+{
+  assert(0 != block_size_);
+  stream_.write(magic(encoding_).data(), static_cast<std::streamsize>(magic_size));
+  offset_ = magic_size;
+}
+
+// The main entry is stored first, followed by the composed entries if any.
+void io1::ColumnarArchiveWriter::add(Statement const & statement)
+{
+  auto const add_entry = [this](Entry const & entry)
+  {
+    amounts_.push_back(entry.amount().data());
+    days_.push_back(ListingColumns::to_day(entry.date()));
+    descriptions_ += entry.description();
+    assert(std::numeric_limits<std::uint32_t>::max() >= descriptions_.size());
+    description_ends_.push_back(static_cast<std::uint32_t>(descriptions_.size()));
+  };
+
+  add_entry(statement.main_entry());
+  for (auto const & entry : statement.composed_entries()) add_entry(entry);
+  entry_counts_.push_back(static_cast<std::uint32_t>(1 + statement.entry_count()));
+
+  if (block_size_ == entry_counts_.size()) write_block();
+}
+
+void io1::ColumnarArchiveWriter::finish(void)
+{
+  write_block();
+
+  std::string footer;
+  append(footer, static_cast<std::uint32_t>(name_.size()));
+  footer += name_;
+  append(footer, block_count_);
+  footer += footer_;
+
+  footer += checksum(algorithm_, footer).digest();
+  append(footer, static_cast<std::uint32_t>(algorithm_));
+  append(footer, static_cast<std::uint64_t>(footer.size() - digest_length(algorithm_) - sizeof(std::uint32_t)));
+  footer += magic(encoding_);
+
+  stream_.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+  offset_ += footer.size();
+}
+
+void io1::ColumnarArchiveWriter::write_block(void)
+{
+  if (entry_counts_.empty()) return;
+
+  std::string block;
+  if (encoding_type::compressed == encoding_) encode_compressed(block);
+  else encode_fixed(block);
+
+  // the date of a statement is the one of its main entry.
+  auto first_day = std::numeric_limits<ListingColumns::day_type>::max();
+  auto last_day = std::numeric_limits<ListingColumns::day_type>::min();
+  std::size_t main_entry = 0;
+  for (auto const entry_count : entry_counts_)
+  {
+    first_day = std::min(first_day, days_[main_entry]);
+    last_day = std::max(last_day, days_[main_entry]);
+    main_entry += entry_count;
+  }
+
+  append(footer_, offset_);
+  append(footer_, static_cast<std::uint64_t>(block.size()));
+  append(footer_, static_cast<std::uint32_t>(entry_counts_.size()));
+  append(footer_, static_cast<std::uint32_t>(amounts_.size()));
+  append(footer_, first_day);
+  append(footer_, last_day);
+  footer_ += checksum(algorithm_, block).digest();
+
+  stream_.write(block.data(), static_cast<std::streamsize>(block.size()));
+  offset_ += block.size();
+  ++block_count_;
+
+  amounts_.clear();
+  days_.clear();
+  entry_counts_.clear();
+  description_ends_.clear();
+  descriptions_.clear();
+}
+
+// Columns are written one after the other: amounts, days, entry counts, description ends and the description blob.
+void io1::ColumnarArchiveWriter::encode_fixed(std::string & block) const
+{
+  block.reserve(amounts_.size() * 16 + entry_counts_.size() * 4 + descriptions_.size());
+  append_column(block, amounts_);
+  append_column(block, days_);
+  append_column(block, entry_counts_);
+  append_column(block, description_ends_);
+  block += descriptions_;
+}
+
+// The dictionary lists the distinct descriptions in the order they first appear, each one preceded by its size.
+void io1::ColumnarArchiveWriter::encode_compressed(std::string & block) const
+{
+  std::unordered_map<std::string_view, std::uint64_t> dictionary;
+  std::vector<std::string_view> distinct_descriptions;
+  std::vector<std::uint64_t> description_indices;
+  description_indices.reserve(description_ends_.size());
+
+  std::uint32_t description_begin = 0;
+  for (auto const description_end : description_ends_)
+  {
+    auto const description = std::string_view(descriptions_).substr(description_begin, description_end - description_begin);
+    auto const [position, inserted] = dictionary.try_emplace(description, distinct_descriptions.size());
+    if (inserted) distinct_descriptions.push_back(description);
+    description_indices.push_back(position->second);
+    description_begin = description_end;
+  }
+
+  append_varint(block, distinct_descriptions.size());
+  for (auto const description : distinct_descriptions)
+  {
+    append_varint(block, description.size());
+    block += description;
+  }
+
+  std::size_t entry = 0;
+  std::int64_t previous_day = 0;
+  for (auto const entry_count : entry_counts_)
+  {
+    append_varint(block, entry_count);
+    for (auto const last = entry + entry_count; last > entry; ++entry)
+    {
+      append_varint(block, zigzag(days_[entry] - previous_day));
+      append_varint(block, zigzag(amounts_[entry]));
+      append_varint(block, description_indices[entry]);
+      previous_day = days_[entry];
+    }
+  }
+}
+
+// The trailer is read backwards from the end of the file, it gives the size of the footer, which is checked before it is parsed.
+io1::ColumnarArchive::ColumnarArchive(std::string_view bytes)
+:bytes_(bytes)
+{
+  if (!is_columnar(bytes_) || 2 * magic_size + trailer_size > bytes_.size() || bytes_.substr(0, magic_size) != bytes_.substr(bytes_.size() - magic_size)) throw_corrupted();
+  if (compressed_magic == bytes_.substr(0, magic_size)) encoding_ = encoding_type::compressed;
+
+  auto const footer_size = load<std::uint64_t>(bytes_, bytes_.size() - magic_size - 8);
+  auto const algorithm_value = load<std::uint32_t>(bytes_, bytes_.size() - trailer_size);
+  if (static_cast<std::uint32_t>(HashAlgorithm::xxh64) < algorithm_value) throw_corrupted();
+  auto const algorithm = static_cast<HashAlgorithm>(algorithm_value);
+
+  auto const digest_size = digest_length(algorithm);
+  if (magic_size + trailer_size + digest_size > bytes_.size() || bytes_.size() - magic_size - trailer_size - digest_size < footer_size) throw_corrupted();
+  auto const footer_offset = bytes_.size() - trailer_size - digest_size - footer_size;
+  auto const footer = bytes_.substr(footer_offset, footer_size);
+  if (parse_digest(algorithm, bytes_.substr(footer_offset + footer_size, digest_size)) != checksum(algorithm, footer)) throw_corrupted();
+
+  ByteReader reader(footer);
+  name_ = reader.take(reader.take<std::uint32_t>());
+  auto const block_count = reader.take<std::uint64_t>();
+  if (footer.size() / 32 < block_count) throw_corrupted(); // each descriptor takes more than 32 bytes.
+
+  blocks_.reserve(block_count);
+  for (std::uint64_t i = 0; block_count > i; ++i)
+  {
+    auto & block = blocks_.emplace_back();
+    block.offset = reader.take<std::uint64_t>();
+    block.size = reader.take<std::uint64_t>();
+    block.statement_count = reader.take<std::uint32_t>();
+    block.entry_count = reader.take<std::uint32_t>();
+    block.first_day = reader.take<day_type>();
+    block.last_day = reader.take<day_type>();
+    block.checksum = parse_digest(algorithm, reader.take(digest_size));
+
+    if (magic_size > block.offset || footer_offset < block.offset || footer_offset - block.offset < block.size) throw_corrupted();
+  }
+  if (!reader.done()) throw_corrupted();
+}
+
+std::size_t io1::ColumnarArchive::size(void) const
+{
+  std::size_t size = 0;
+  for (auto const & block : blocks_) size += block.statement_count;
+  return size;
+}
+
+io1::ColumnarArchive::listing_type io1::ColumnarArchive::listing(void) const
+{
+  std::vector<Statement> statements;
+  statements.reserve(size());
+  for (std::size_t block = 0; blocks_.size() > block; ++block) decode_block(block, statements);
+
+  return listing_type(QString::fromStdString(name_), boost::make_iterator_range(std::make_move_iterator(statements.begin()), std::make_move_iterator(statements.end())));
+}
+
+void io1::ColumnarArchive::read_block(std::size_t block, std::vector<Statement> & statements) const
+{
+  auto const & descriptor = blocks_.at(block);
+  auto const actual_checksum = checksum(descriptor.checksum.algorithm(), bytes_.substr(descriptor.offset, descriptor.size));
+  if (descriptor.checksum != actual_checksum)
+    BOOST_THROW_EXCEPTION(Sha1Mismatch() << BlockChecksums::errinfo_block_index(block) << Sha1Mismatch::errinfo_expected(descriptor.checksum.to_string()) << Sha1Mismatch::errinfo_actual(actual_checksum.to_string()));
+
+  return decode_block(block, statements);
+}
+
+std::vector<io1::Statement> io1::ColumnarArchive::statements_between(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const
+{
+  auto const first_day = ListingColumns::to_day(from);
+  auto const last_day = ListingColumns::to_day(to);
+
+  std::vector<Statement> statements;
+  std::vector<Statement> block_statements;
+  for (std::size_t block = 0; blocks_.size() > block; ++block)
+  {
+    if (blocks_[block].last_day < first_day || last_day < blocks_[block].first_day) continue;
+
+    block_statements.clear();
+    read_block(block, block_statements);
+    std::copy_if(std::make_move_iterator(block_statements.begin()), std::make_move_iterator(block_statements.end()), std::back_inserter(statements), [=](Statement const & statement)
+    {
+      auto const day = ListingColumns::to_day(statement.main_entry().date());
+      return first_day <= day && day <= last_day;
+    });
+  }
+
+  return statements;
+}
+
+bool io1::ColumnarArchive::is_columnar(std::string_view bytes)
+{
+  return bytes.starts_with(fixed_magic) || bytes.starts_with(compressed_magic);
+}
+
+void io1::ColumnarArchive::decode_block(std::size_t block, std::vector<Statement> & statements) const
+{
+  auto const & descriptor = blocks_[block];
+  auto const data = bytes_.substr(descriptor.offset, descriptor.size);
+
+  statements.reserve(statements.size() + descriptor.statement_count);
+  if (encoding_type::compressed == encoding_) return decode_compressed(data, descriptor.statement_count, descriptor.entry_count, statements);
+  return decode_fixed(data, descriptor.statement_count, descriptor.entry_count, statements);
+}
@@ -1,13 +1,10 @@
 #include "io1/entry.hpp"
-#include <format>
 #include <iostream>
-/*#include <iomanip>
-#include <boost/format.hpp>
+#include <iterator>
+#include <charconv>
+#include <cctype>
 #include <boost/throw_exception.hpp>
-#include <boost/exception_ptr.hpp>
-#include "date_formatter.hpp"
 #include "accounting_exception.hpp"
-#include "blank.hpp"*/
 
 // Constructs an entry with the given amount, dated today.
 io1::Entry::Entry(Money amount) noexcept
@@ -40,28 +37,89 @@ io1::Entry::Entry(Money amount, std::string description, std::chrono::year_month
 // Formats an entry into an std::ostream.
 std::ostream & io1::Entry::write(std::ostream & stream) const
 {
-  return stream << std::format("{:<10}{:<10}{}\n", date_, amount_.data(), description_);
+  std::string buffer;
+  format_to(std::back_inserter(buffer));
+  return stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
-/*// Reads an entry from an std::istream.
+namespace
+{
+  using amount_type = decltype(std::declval<io1::Money>().data());
+
+  auto const date_size = 10; // yyyy-mm-dd, as written by std::format.
+
+  [[nodiscard]] bool is_blank(char c) noexcept { return ' ' == c || '\t' == c; }
+
+  // Returns the position of the first non blank character of buffer at or after position.
+  [[nodiscard]] std::size_t skip_blanks(std::string_view buffer, std::size_t position) noexcept
+  {
+    while (position < buffer.size() && is_blank(buffer[position])) ++position;
+    return position;
+  }
+
+  // Parses an unsigned or signed integer that must span the whole field.
+  template<typename T> [[nodiscard]] bool parse_field(std::string_view field, T & value) noexcept
+  {
+    auto const [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return std::errc{} == error && field.data() + field.size() == end;
+  }
+
+  // Parses a yyyy-mm-dd date.
+  [[nodiscard]] std::chrono::year_month_day parse_date(std::string_view field)
+  {
+    int year{};
+    unsigned month{}, day{};
+
+    if (date_size != field.size() || '-' != field[4] || '-' != field[7]
+      || !parse_field(field.substr(0, 4), year) || !parse_field(field.substr(5, 2), month) || !parse_field(field.substr(8, 2), day))
+      BOOST_THROW_EXCEPTION(io1::InvalidDateFormat{} << io1::InvalidDateFormat::errinfo_date_string{ std::string(field) });
+
+    std::chrono::year_month_day const date{ std::chrono::year{ year }, std::chrono::month{ month }, std::chrono::day{ day } };
+    if (!date.ok()) BOOST_THROW_EXCEPTION(io1::InvalidDateFormat{} << io1::InvalidDateFormat::errinfo_date_string{ std::string(field) });
+
+    return date;
+  }
+}
+
+// Reads an entry from an std::istream.
 io1::Entry io1::Entry::read(std::istream & stream)
 {
-  QDate date;
-  stream >> blank >> date;
+  std::string line;
+  if (!std::getline(stream, line)) BOOST_THROW_EXCEPTION(ParseError{} << ParseError::errinfo_class_name{"Entry"});
 
-  Money amount;
-  stream >> amount;
+  Entry entry;
+  read(line, entry);
 
-  std::string description;
-  std::getline(stream >> blank,description);
+  return entry;
+}
+
+// Reads an entry from the beginning of a buffer, up to and including the end of line.
+std::size_t io1::Entry::read(std::string_view buffer, Entry & entry)
+{
+  auto position = skip_blanks(buffer, 0);
+  entry.date_ = parse_date(buffer.substr(position, date_size));
+  position += date_size;
 
-  if (!stream) BOOST_THROW_EXCEPTION(ParseError{} << ParseError::errinfo_class_name{"Entry"});
+  position = skip_blanks(buffer, position);
+  amount_type amount{};
+  auto const [amount_end, error] = std::from_chars(buffer.data() + position, buffer.data() + buffer.size(), amount);
+  if (std::errc{} != error) BOOST_THROW_EXCEPTION(ParseError{} << ParseError::errinfo_class_name{"Entry"});
+  entry.amount_ = Money{ amount };
+  position = skip_blanks(buffer, static_cast<std::size_t>(amount_end - buffer.data()));
 
-  return Entry{amount, QString::fromStdString(description), std::move(date)};
+  auto end_of_line = buffer.find('\n', position);
+  auto const consumed = (std::string_view::npos == end_of_line) ? buffer.size() : end_of_line + 1;
+  if (std::string_view::npos == end_of_line) end_of_line = buffer.size();
+
+  // the description is trimmed, which also takes care of CRLF line endings.
+  while (end_of_line > position && std::isspace(static_cast<unsigned char>(buffer[end_of_line - 1]))) --end_of_line;
+  entry.description_.assign(buffer.data() + position, end_of_line - position);
+
+  return consumed;
 }
 
 // Returns true if rhs is the same as the object.
 bool io1::Entry::equals(Entry const & rhs) const
 {
   return (description_ == rhs.description_ && date_ == rhs.date_ && amount_ == rhs.amount_);
-}*/
\ No newline at end of file
+}
@@ -1,13 +1,17 @@
 /// \file listing.cpp
 #include "listing.hpp"
+#include "io1/parallel_sort.hpp"
+#include "io1/accounting_exception.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <iterator>
-#include <boost/format.hpp>
+#include <numeric>
+#include <type_traits>
 #include <boost/range/adaptor/reversed.hpp>
-#include <boost/range/adaptor/sliced.hpp>
 #include <boost/range/algorithm/copy.hpp>
-#include <boost/range/algorithm/sort.hpp>
+#include <boost/range/algorithm/inplace_merge.hpp>
 #include <boost/range/algorithm/stable_sort.hpp>
+#include <boost/range/numeric.hpp>
 
 namespace
 {
@@ -19,29 +23,97 @@ template<typename COMMITTABLE> io1::Listing<COMMITTABLE>::Listing(QString name)
 :name_(std::move(name))
 {}
 
+template<typename COMMITTABLE> io1::Listing<COMMITTABLE>::Listing(QString name, vector_type statements, Money total_amount, std::size_t sorted_size)
+:name_(std::move(name)),statements_(std::move(statements)),commit_states_(statements_.size()),total_amount_(total_amount),sorted_size_(sorted_size)
+{
+  assert(sorted_prefix_size() == sorted_size_);
+  check_total_amount();
+}
+
 template<typename COMMITTABLE>
-void io1::Listing<COMMITTABLE>::sort(void)
+void io1::Listing<COMMITTABLE>::sort(unsigned thread_count)
 {
-  boost::range::sort(statements_, sort_predicate<statement_type>);
-  return;
+  return sort_impl([thread_count](auto first, auto last, auto compare) { parallel_sort(first, last, compare, thread_count); });
 }
 
 template<typename COMMITTABLE>
-void io1::Listing<COMMITTABLE>::stable_sort(void)
+void io1::Listing<COMMITTABLE>::stable_sort(unsigned thread_count)
+{
+  return sort_impl([thread_count](auto first, auto last, auto compare) { parallel_stable_sort(first, last, compare, thread_count); });
+}
+
+// Only the statements that follow the sorted prefix are sorted, they are then merged into the prefix.
+// Merging keeps the prefix statements before the tail statements of the same date, which preserves stability.
+template<typename COMMITTABLE> template<typename SORT> void io1::Listing<COMMITTABLE>::sort_impl(SORT sort_tail)
 {
-  boost::range::stable_sort(statements_, sort_predicate<statement_type>);
+  if (is_sorted()) return;
+
+  if (!has_handles() && commit_states_.none())
+  {
+    auto const middle = statements_.begin() + sorted_size_;
+    sort_tail(middle, statements_.end(), sort_predicate<statement_type>);
+    boost::range::inplace_merge(statements_, middle, sort_predicate<statement_type>);
+  }
+  else
+  {
+    // positions are sorted instead of statements, the resulting permutation is then applied to the statements, their commit states and handle slots.
+    std::vector<std::uint32_t> order(statements_.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto const by_date = [this](std::uint32_t lhs, std::uint32_t rhs) { return statements_[lhs].date() < statements_[rhs].date(); };
+
+    auto const middle = order.begin() + sorted_size_;
+    sort_tail(middle, order.end(), by_date);
+    std::inplace_merge(order.begin(), middle, order.end(), by_date);
+
+    vector_type sorted_statements;
+    sorted_statements.reserve(statements_.size());
+    SelectionBitmap sorted_states(statements_.size());
+    std::vector<std::uint32_t> sorted_slots;
+    sorted_slots.reserve(position_slots_.size());
+    for (std::size_t i = 0; order.size() > i; ++i)
+    {
+      sorted_statements.push_back(std::move(statements_[order[i]]));
+      if (commit_states_.test(order[i])) sorted_states.set(i);
+      if (has_handles()) sorted_slots.push_back(position_slots_[order[i]]);
+    }
+    statements_ = std::move(sorted_statements);
+    commit_states_ = std::move(sorted_states);
+    if (has_handles())
+    {
+      position_slots_ = std::move(sorted_slots);
+      update_handle_positions(0, statements_.size());
+    }
+  }
+
+  sorted_size_ = statements_.size();
+  clear_journal();
+  reset_caches();
   return;
 }
 
 template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_iterator io1::Listing<COMMITTABLE>::erase_statement(const_iterator position)
 {
-  assert(statements_.end() > position);
-  return statements_.erase(position);
+  assert(end() > position);
+  total_amount_ -= position->amount();
+  if (position < begin() + sorted_size_) --sorted_size_; // removing a statement keeps the prefix sorted.
+  if (date_index_) // the index looks the statement up by its date, before the journal takes it.
+  {
+    remove_from_date_index(position - begin());
+    shift_date_index(position - begin() + 1, statements_.size(), -1);
+  }
+  if (journaling()) journal_replacement(position - begin(), 0, vector_type(std::make_move_iterator(remove_const(position)), std::make_move_iterator(remove_const(position + 1))));
+  commit_states_.erase(position - begin(), position - begin() + 1);
+  replace_handles(position - begin(), position - begin() + 1, 0);
+  invalidate_statements(position - begin());
+  auto const next = statements_.erase(to_vector_iterator(position));
+  check_total_amount();
+
+  return to_iterator(next);
 }
 
 template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_iterator io1::Listing<COMMITTABLE>::group_range(QString description, QDate date, const_range statements)
 {
-  assert(statements_.end() >= statements.end());
+  assert(end() >= statements.end());
   switch (statements.size())
   {
     case 0: // return statements.end(), which is the same as statements.begin().
@@ -49,110 +121,389 @@ template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_iterato
     default: break;
   }
 
+  // the journal keeps a copy of the grouped statements, their entries are then moved into the group.
+  if (journaling()) journal_replacement(statements.begin() - begin(), 1, vector_type(statements.begin(), statements.end()));
+  auto combined_entries = combine_entries(statements);
+
+  truncate_sorted_prefix(statements.begin());
+  commit_states_.erase(statements.begin() - begin() + 1, statements.end() - begin());
+  commit_states_.reset(statements.begin() - begin()); // the group is not committed.
+  replace_handles(statements.begin() - begin(), statements.end() - begin(), 1);
+  reset_caches(statements.begin() - begin());
+  auto const position = statements_.erase(to_vector_iterator(statements.begin()), to_vector_iterator(statements.end()));
+  auto const group = statements_.emplace(position, std::move(description), std::move(date), std::move(combined_entries));
+  check_total_amount(); // the amount of the group is the sum of the amounts of the grouped statements.
+
+  return to_iterator(group);
+}
+
+// The statements are left unassigned, they must be erased.
+template<typename COMMITTABLE> std::vector<io1::Entry> io1::Listing<COMMITTABLE>::combine_entries(const_range statements)
+{
   std::vector<Entry> combined_entries;
-  for (auto const & statement : statements)
-  {
-    if (!statement.is_composed()) combined_entries.push_back(statement.main_entry());
-    else
-    {
-      boost::range::copy(statement.composed_entries(), std::back_inserter(combined_entries));
-    }
-  }
+  combined_entries.reserve(boost::accumulate(statements, std::size_t{ 0 }, [](std::size_t count, statement_type const & statement) { return count + std::max<std::size_t>(1, statement.entry_count()); }));
+
+  for (auto statement = statements.begin(); statements.end() != statement; ++statement)
+    remove_const(statement)->move_entries_to(std::back_inserter(combined_entries));
 
-  auto const position = statements_.erase(statements.begin(), statements.end());
-  return statements_.emplace(position, std::move(description), std::move(date), std::move(combined_entries));
+  return combined_entries;
 }
 
 template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_range io1::Listing<COMMITTABLE>::gather_selection(statement_selection const & selected_statements)
 {
-  switch (selected_statements.size())
+  if (selected_statements.empty()) return boost::make_iterator_range(end(),end());
+
+  // selected positions are visited in increasing order, so walking the selection alongside is enough to test them.
+  auto selected = selected_statements.begin();
+  return gather_window(*selected_statements.begin() - begin(), *selected_statements.rbegin() - begin() + 1, selected_statements.size(), [&](std::size_t position)
   {
-    case 0: return boost::make_iterator_range(statements_.end(),statements_.end());
-    case 1:
+    if (selected_statements.end() == selected || begin() + position != *selected) return false;
+    ++selected;
+    return true;
+  });
+}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_range io1::Listing<COMMITTABLE>::gather_selection(handle_selection const & selected_statements)
+{
+  return gather_selection(resolve(selected_statements));
+}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_range io1::Listing<COMMITTABLE>::gather_selection(SelectionBitmap const & selected_statements)
+{
+  assert(statements_.size() == selected_statements.size());
+  auto const first = selected_statements.find_first();
+  if (selected_statements.size() == first) return boost::make_iterator_range(end(),end());
+
+  return gather_window(first, selected_statements.find_last() + 1, selected_statements.count(), [&](std::size_t position) { return selected_statements.test(position); });
+}
+
+// Moves the selected elements next to the last one so as to define a range that will then be range_grouped.
+// This is a stable partition of the window [first, last) that spans from the first to the last selected statement.
+template<typename COMMITTABLE> template<typename IS_SELECTED> typename io1::Listing<COMMITTABLE>::const_range io1::Listing<COMMITTABLE>::gather_window(std::size_t first, std::size_t last, std::size_t count, IS_SELECTED is_selected)
+{
+  assert(statements_.size() >= last);
+  assert(first < last);
+
+  // already contiguous, nothing to move.
+  if (last - first == count) return boost::make_iterator_range(begin() + first, begin() + last);
+
+  // selected statements are set aside while the others are compacted towards the beginning of the window, in a single pass.
+  // The first statement is selected so the compacted statements are never moved onto themselves.
+  std::vector<statement_type> gathered_statements;
+  gathered_statements.reserve(count);
+
+  SelectionBitmap gathered_states;
+  std::vector<std::uint32_t> gathered_slots;
+
+  auto output = first;
+  for (auto position = first; last != position; ++position)
+  {
+    if (is_selected(position))
     {
-      auto const statement = *selected_statements.begin();
-      assert(statements_.end() > statement);
-      return boost::make_iterator_range(statement,statement+1);
+      gathered_statements.push_back(std::move(statements_[position]));
+      gathered_states.push_back(commit_states_.test(position));
+      if (has_handles()) gathered_slots.push_back(position_slots_[position]);
+    }
+    else
+    {
+      if (has_handles()) position_slots_[output] = position_slots_[position];
+      commit_states_.assign(output, commit_states_.test(position));
+      statements_[output++] = std::move(statements_[position]);
     }
-    default: break;
   }
+  assert(gathered_statements.size() == count);
 
-  // Moves the selected elements next to the last one so as to define a range that will then be range_grouped.
-
-  // begin and end of the range that will be ranged_grouped.
-  auto const end_range = 1+*selected_statements.rbegin();
-  auto begin_range = end_range; // Will be set to the right value throughout the for loop below.
-
-  // rotate each selected iterator to the right, and update begin_range accordingly.
-  for (auto const_statement : selected_statements | boost::adaptors::reversed)
+  // the selected statements fill the end of the window.
+  std::move(gathered_statements.begin(), gathered_statements.end(), statements_.begin() + output);
+  for (std::size_t i = 0; count > i; ++i) commit_states_.assign(output + i, gathered_states.test(i));
+  if (has_handles())
   {
-    move_statement_up(const_statement,--begin_range);
+    boost::range::copy(gathered_slots, position_slots_.begin() + output);
+    update_handle_positions(first, last);
   }
+  truncate_sorted_prefix(begin() + first);
+  clear_journal();
+  reset_caches(first, last);
 
   // ready to call range_group.
-  return boost::make_iterator_range(begin_range, end_range);
+  return boost::make_iterator_range(begin() + output, begin() + last);
 }
 
 template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::move_statement(const_iterator statement, const_iterator position)
 {
-  assert(statements_.end() > statement);
+  assert(end() > statement);
   return (statement < position) ? move_statement_up(statement,position) : move_statement_down(statement,position);
 }
 
 template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::move_statement_up(const_iterator statement, const_iterator position)
 {
-  assert(statements_.end() > statement);
-  assert(statements_.end() > position);
+  assert(end() > statement);
+  assert(end() > position);
   assert(statement <= position); // otherwise we are actually trying to move down.
 
   auto const non_const_reversed_statement = std::make_reverse_iterator(remove_const(statement+1));
   auto const non_const_reversed_position = std::make_reverse_iterator(remove_const(position+1));
 
+  if (date_index_)
+  {
+    remove_from_date_index(statement - begin());
+    shift_date_index(statement - begin() + 1, position - begin() + 1, -1);
+  }
   std::rotate(non_const_reversed_position, non_const_reversed_statement, non_const_reversed_statement+1 );
+  rotate_commit_state(statement - begin(), position - begin());
+  if (journaling()) journal(move_record{ static_cast<std::size_t>(position - begin()), static_cast<std::size_t>(statement - begin()) });
+  if (has_handles())
+  {
+    auto const first = position_slots_.begin() + (statement - begin());
+    auto const last = position_slots_.begin() + (position - begin()) + 1;
+    std::rotate(first, first + 1, last);
+    update_handle_positions(statement - begin(), position - begin() + 1);
+  }
+  if (date_index_) insert_in_date_index(position - begin());
+  truncate_sorted_prefix(statement);
+  invalidate_statements(statement - begin(), position - begin() + 1);
   return;
 }
 
 template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::move_statement_down(const_iterator statement, const_iterator position)
 {
-  assert(statements_.end() > statement);
-  assert(statements_.end() > position);
+  assert(end() > statement);
+  assert(end() > position);
   assert(statement >= position); // otherwise we are actually moving up.
 
   auto const non_const_statement = remove_const(statement);
+  if (date_index_)
+  {
+    remove_from_date_index(statement - begin());
+    shift_date_index(position - begin(), statement - begin(), 1);
+  }
   std::rotate(remove_const(position), non_const_statement, non_const_statement+1);
+  rotate_commit_state(statement - begin(), position - begin());
+  if (journaling()) journal(move_record{ static_cast<std::size_t>(position - begin()), static_cast<std::size_t>(statement - begin()) });
+  if (has_handles())
+  {
+    auto const first = position_slots_.begin() + (position - begin());
+    auto const middle = position_slots_.begin() + (statement - begin());
+    std::rotate(first, middle, middle + 1);
+    update_handle_positions(position - begin(), statement - begin() + 1);
+  }
+  if (date_index_) insert_in_date_index(position - begin());
+  truncate_sorted_prefix(position);
+  invalidate_statements(position - begin(), statement - begin() + 1);
   return;
 }
 
 template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_range io1::Listing<COMMITTABLE>::split_statement(const_iterator statement)
 {
-  assert(statements_.end() > statement);
+  assert(end() > statement);
   if (!statement->is_composed()) return boost::make_iterator_range(statement,statement+1);
 
-  auto const entries = statement->composed_entries();
-  auto const nb_entries = entries.size();
-
-  // we simply alter the first statement inplace.
-  alter_statement(statement++,*entries.begin());
+  auto const position = statement - begin();
+  auto const nb_entries = statement->entry_count();
 
-  // the others need to be inserted right after.
-  std::vector<statement_type> new_statements;
-  for (auto const & entry: entries | boost::adaptors::sliced(1,entries.size()))
-    new_statements.emplace_back(entry);
+  if (journaling()) journal_replacement(position, nb_entries, vector_type(statement, statement + 1));
+  truncate_sorted_prefix(statement);
+  commit_states_.insert(position + 1, nb_entries - 1, false);
+  commit_states_.reset(position); // the entries are not committed.
+  replace_handles(position + 1, position + 1, nb_entries - 1); // the first entry keeps the handle of the split statement.
+  reset_caches(position);
 
-  auto const begin_range = --statements_.insert(statement,std::make_move_iterator(new_statements.begin()),std::make_move_iterator(new_statements.end()));
+  // room is made for the other entries with a single shift of the tail, then each entry is moved into its own statement.
+  // The total amount is unchanged.
+  statements_.insert(to_vector_iterator(statement) + 1, nb_entries - 1, statement_type{});
+  auto const begin_range = statements_.begin() + position;
+  std::vector<Entry> entries;
+  entries.reserve(nb_entries);
+  begin_range->move_entries_to(std::back_inserter(entries));
+  std::transform(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()), begin_range, [](Entry && entry) { return statement_type(std::move(entry)); });
+  check_total_amount(); // the amounts of the composed entries add up to the amount of the split statement.
 
-  return boost::make_iterator_range(begin_range,begin_range+nb_entries);
+  return boost::make_iterator_range(to_iterator(begin_range),to_iterator(begin_range+nb_entries));
 }
 
 template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::swap_statements(const_iterator position1, const_iterator position2)
 {
-  assert(statements_.end() > position1);
-  assert(statements_.end() > position2);
+  assert(end() > position1);
+  assert(end() > position2);
+
+  auto & statement1 = *remove_const(position1);
+  auto & statement2 = *remove_const(position2);
+
+  auto const index1 = static_cast<std::size_t>(position1 - begin());
+  auto const index2 = static_cast<std::size_t>(position2 - begin());
+
+  truncate_sorted_prefix(std::min(position1, position2));
+  if (journaling()) journal(swap_record{ index1, index2 });
+  auto const committed1 = commit_states_.test(index1);
+  commit_states_.assign(index1, commit_states_.test(index2));
+  commit_states_.assign(index2, committed1);
+  if (has_handles())
+  {
+    std::swap(position_slots_[index1], position_slots_[index2]);
+    update_handle_positions(index1, index1 + 1);
+    update_handle_positions(index2, index2 + 1);
+  }
+  invalidate_statements(index1, index1 + 1);
+  invalidate_statements(index2, index2 + 1);
+  if (!date_index_) return std::swap(statement1, statement2);
+
+  remove_from_date_index(index1);
+  if (index1 != index2) remove_from_date_index(index2);
+  std::swap(statement1, statement2);
+  insert_in_date_index(index1);
+  if (index1 != index2) insert_in_date_index(index2);
+  return;
+}
+
+template<typename COMMITTABLE> io1::Listing<COMMITTABLE>::Transaction::Transaction(Listing & listing)
+:listing_(listing),edited_(listing.statements_.size())
+{}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::Transaction & io1::Listing<COMMITTABLE>::Transaction::erase(const_iterator statement)
+{
+  assert(listing_.end() > statement);
+  mark_edited(position(statement), position(statement) + 1);
+  removed_.push_back(position(statement));
+  return *this;
+}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::Transaction & io1::Listing<COMMITTABLE>::Transaction::move(const_iterator statement, const_iterator position)
+{
+  assert(listing_.end() > statement);
+  mark_edited(this->position(statement), this->position(statement) + 1);
+  insertions_.push_back({ this->position(position), true, this->position(statement) });
+  return *this;
+}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::Transaction & io1::Listing<COMMITTABLE>::Transaction::group(QString description, QDate date, const_range statements)
+{
+  assert(listing_.end() >= statements.end());
+  if (2 > statements.size()) return *this; // as group_range, grouping less than two statements does nothing.
 
-  auto & statement1 = const_cast<statement_type &>(*position1);
-  auto & statement2 = const_cast<statement_type &>(*position2);
+  mark_edited(position(statements.begin()), position(statements.end()));
+  for (auto statement = statements.begin(); statements.end() != statement; ++statement) removed_.push_back(position(statement));
 
-  return std::swap(statement1, statement2);
+  // the group takes its place among the insertions now, so that it keeps its recording order. It is built by commit.
+  insertions_.push_back({ position(statements.begin()), false, new_statements_.size() });
+  groups_.push_back({ position(statements.begin()), position(statements.end()), std::move(description), std::move(date), new_statements_.size() });
+  new_statements_.emplace_back();
+  return *this;
+}
+
+// Nothing is marked when a statement is already edited, the transaction is left as it was.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::Transaction::mark_edited(std::size_t first, std::size_t last)
+{
+  assert(edited_.size() >= last);
+  for (auto position = first; last > position; ++position)
+    if (edited_.test(position)) BOOST_THROW_EXCEPTION(StatementEditedTwice{} << StatementEditedTwice::errinfo_position(position));
+
+  for (auto position = first; last > position; ++position) edited_.set(position);
+}
+
+// The statements are rebuilt in a single pass over the original positions. Each position first receives the statements inserted,
+// moved or grouped before it, in the order they were recorded, then the statement it held unless it was removed or altered.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::Transaction::commit(void)
+{
+  auto & statements = listing_.statements_;
+  auto const size = statements.size();
+
+  // groups are built first, out of the original statements, in the places reserved when they were recorded.
+  for (auto & group : groups_)
+  {
+    auto const grouped = boost::make_iterator_range(listing_.begin() + group.first, listing_.begin() + group.last);
+    new_statements_[group.statement] = statement_type(std::move(group.description), std::move(group.date), listing_.combine_entries(grouped));
+  }
+
+  // no_edit for a kept statement, removed or moved, otherwise the position of its replacement in new_statements_.
+  constexpr auto no_edit = std::numeric_limits<std::size_t>::max();
+  constexpr auto removed = no_edit - 1;
+  constexpr auto moved = no_edit - 2;
+  std::vector<std::size_t> edits(size, no_edit);
+  for (auto const position : removed_)
+  {
+    assert(no_edit == edits[position]); // mark_edited rejected second edits when they were recorded.
+    edits[position] = removed;
+  }
+  for (auto const & insertion : insertions_)
+  {
+    if (!insertion.original) continue;
+    assert(no_edit == edits[insertion.source]);
+    edits[insertion.source] = moved;
+  }
+  for (auto const & [position, replacement] : alterations_)
+  {
+    assert(no_edit == edits[position]);
+    edits[position] = replacement;
+  }
+
+  boost::range::stable_sort(insertions_, [](insertion_type const & lhs, insertion_type const & rhs) { return lhs.position < rhs.position; });
+
+  vector_type rebuilt_statements;
+  rebuilt_statements.reserve(size + insertions_.size());
+  SelectionBitmap rebuilt_states; // moved and kept statements keep their commit state, the others are not committed.
+  std::vector<std::uint32_t> rebuilt_slots;
+  if (listing_.has_handles()) rebuilt_slots.reserve(rebuilt_statements.capacity());
+
+  auto insertion = insertions_.cbegin();
+  auto const insert_before = [&](std::size_t position)
+  {
+    for (; insertions_.cend() != insertion && position == insertion->position; ++insertion)
+    {
+      if (insertion->original)
+      {
+        rebuilt_statements.push_back(std::move(statements[insertion->source]));
+        rebuilt_states.push_back(listing_.commit_states_.test(insertion->source));
+        if (listing_.has_handles()) rebuilt_slots.push_back(listing_.position_slots_[insertion->source]);
+      }
+      else
+      {
+        rebuilt_statements.push_back(std::move(new_statements_[insertion->source]));
+        rebuilt_states.push_back(false);
+        if (listing_.has_handles()) rebuilt_slots.push_back(no_slot);
+      }
+    }
+  };
+
+  for (std::size_t position = 0; size > position; ++position)
+  {
+    insert_before(position);
+    if (moved == edits[position]) continue; // moved statements keep their slot.
+    if (removed == edits[position])
+    {
+      if (listing_.has_handles() && no_slot != listing_.position_slots_[position]) listing_.free_slot(listing_.position_slots_[position]);
+      continue;
+    }
+
+    rebuilt_statements.push_back(std::move(no_edit == edits[position] ? statements[position] : new_statements_[edits[position]]));
+    rebuilt_states.push_back(no_edit == edits[position] && listing_.commit_states_.test(position));
+    if (listing_.has_handles()) rebuilt_slots.push_back(listing_.position_slots_[position]);
+  }
+  insert_before(size);
+  assert(insertions_.cend() == insertion);
+
+  statements = std::move(rebuilt_statements);
+  listing_.commit_states_ = std::move(rebuilt_states);
+  listing_.total_amount_ = boost::accumulate(statements, 0_USD, [](Money total, statement_type const & statement) { return total += statement.amount(); });
+  listing_.sorted_size_ = listing_.sorted_prefix_size();
+  if (listing_.has_handles())
+  {
+    listing_.position_slots_ = std::move(rebuilt_slots);
+    listing_.update_handle_positions(0, statements.size());
+  }
+  listing_.clear_journal();
+  listing_.reset_caches();
+
+  return clear();
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::Transaction::clear(void)
+{
+  edited_ = SelectionBitmap(listing_.statements_.size());
+  removed_.clear();
+  alterations_.clear();
+  insertions_.clear();
+  groups_.clear();
+  new_statements_.clear();
 }
 
 template<typename COMMITTABLE> io1::Listing<COMMITTABLE> io1::Listing<COMMITTABLE>::read(std::istream & stream)
@@ -162,23 +513,56 @@ template<typename COMMITTABLE> io1::Listing<COMMITTABLE> io1::Listing<COMMITTABL
 
   io1::Listing<COMMITTABLE> listing{ QString::fromStdString(title) };
 
-  while (stream)
+  while ((stream >> std::ws).good()) // an empty listing is only its title.
   {
-    statement_type statement;
-    stream >> std::ws >> statement;
-    listing.statements_.push_back(std::move(statement));
+    bool committed = false;
+    if constexpr (is_committable) listing.statements_.push_back(CommittableStatement::read(stream, committed));
+    else listing.statements_.push_back(statement_type::read(stream));
+    listing.commit_states_.push_back(committed);
+    listing.total_amount_ += listing.statements_.back().amount();
   }
+  listing.sorted_size_ = listing.sorted_prefix_size();
+
+  return listing;
+}
+
+// Parse errors are given the line they occurred at.
+template<typename COMMITTABLE> io1::Listing<COMMITTABLE> io1::Listing<COMMITTABLE>::read(std::string_view buffer)
+{
+  auto const whitespaces = " \t\r\n";
+  auto position = std::min(buffer.find_first_not_of(whitespaces), buffer.size());
+  auto const end_of_title = std::min(buffer.find('\n', position), buffer.size());
+
+  io1::Listing<COMMITTABLE> listing{ QString::fromStdString(std::string(buffer.substr(position, end_of_title - position))) };
+  listing.statements_.reserve(static_cast<std::size_t>(std::count(buffer.begin() + end_of_title, buffer.end(), '\n'))); // each statement spans at least one line.
+
+  try
+  {
+    for (position = buffer.find_first_not_of(whitespaces, end_of_title); std::string_view::npos != position; position = buffer.find_first_not_of(whitespaces, position))
+    {
+      bool committed = false;
+      if constexpr (is_committable) position += CommittableStatement::read(buffer.substr(position), listing.statements_.emplace_back(), committed);
+      else position += statement_type::read(buffer.substr(position), listing.statements_.emplace_back());
+      listing.commit_states_.push_back(committed);
+      listing.total_amount_ += listing.statements_.back().amount();
+    }
+  }
+  catch (ParseError & e)
+  {
+    e << ParseError::errinfo_line_number(1 + static_cast<std::size_t>(std::count(buffer.begin(), buffer.begin() + std::min(position, buffer.size()), '\n')));
+    throw;
+  }
+  listing.sorted_size_ = listing.sorted_prefix_size();
 
   return listing;
 }
 
 template<typename COMMITTABLE> std::ostream & io1::Listing<COMMITTABLE>::write(std::ostream & stream) const
 {
-  stream << boost::format("\n%1%\n\n") % name_.toStdString();
-  for (auto const & statement: statements())
-    stream << statement;
+  std::string buffer;
+  format_to(std::back_inserter(buffer));
 
-  return stream;
+  return stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 template<typename COMMITTABLE> std::ostream & io1::operator<<(std::ostream & stream, Listing<COMMITTABLE> const & listing)
@@ -189,18 +573,603 @@ template<typename COMMITTABLE> std::ostream & io1::operator<<(std::ostream & str
 template<typename COMMITTABLE> std::istream & io1::operator>>(std::istream & stream, Listing<COMMITTABLE> & listing)
 {
   listing = Listing<COMMITTABLE>::read(stream);
-  assert(!stream);
+  assert(stream.eof()); // a listing spans the rest of the stream.
   return stream;
 }
 
 template<typename COMMITTABLE> bool io1::Listing<COMMITTABLE>::equals(Listing const & rhs) const
 {
-  return (statements_ == rhs.statements_);
+  return (statements_ == rhs.statements_) && (commit_states_ == rhs.commit_states_);
+}
+
+template<typename COMMITTABLE> io1::ListingColumns const & io1::Listing<COMMITTABLE>::columns(void) const
+{
+  if (!columns_)
+  {
+    columns_.emplace();
+    columns_->reserve(statements_.size());
+    for (std::size_t position = 0; statements_.size() > position; ++position) columns_->push_back(statements_[position].main_entry(), commit_states_.test(position));
+  }
+
+  return *columns_;
+}
+
+// The columns and the block checksums are updated in place.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::set_committed(const_iterator statement, bool committed) requires is_committable
+{
+  assert(end() > statement);
+  auto const position = static_cast<std::size_t>(statement - begin());
+  commit_states_.assign(position, committed);
+  if (columns_) columns_->set_committed(position, committed);
+  if (block_checksums_) block_checksums_->invalidate(position, position + 1);
+}
+
+template<typename COMMITTABLE> io1::SelectionBitmap io1::Listing<COMMITTABLE>::uncommitted_statements(void) const requires is_committable
+{
+  auto uncommitted = commit_states_;
+  uncommitted.flip();
+  return uncommitted;
+}
+
+// The sorted prefix of the extracted statements is computed as they are moved out.
+template<typename COMMITTABLE> io1::Listing<io1::non_committable_tag> io1::Listing<COMMITTABLE>::extract_committed(QString name) requires is_committable
+{
+  using extracted_listing_type = Listing<non_committable_tag>;
+
+  typename extracted_listing_type::vector_type extracted_statements;
+  extracted_statements.reserve(committed_count()); // no reallocation, so the listing never holds more than its statements plus the moved ones.
+  std::size_t extracted_sorted_size = 0;
+
+  auto const extracted_amount = remove_committed([&](statement_type && statement)
+  {
+    if (extracted_sorted_size == extracted_statements.size() && (extracted_statements.empty() || !(statement.date() < extracted_statements.back().date()))) ++extracted_sorted_size;
+    extracted_statements.emplace_back(std::move(statement));
+  });
+
+  return extracted_listing_type(std::move(name), std::move(extracted_statements), extracted_amount, extracted_sorted_size);
+}
+
+template<typename COMMITTABLE> io1::Money io1::Listing<COMMITTABLE>::erase_committed(void) requires is_committable
+{
+  return remove_committed([](statement_type &&) {});
+}
+
+// Stable partition of the statements: the committed ones are handed to the sink while the others are compacted towards the beginning.
+// The total and the sorted prefix of the remaining statements are computed during the same pass.
+template<typename COMMITTABLE> template<typename SINK> io1::Money io1::Listing<COMMITTABLE>::remove_committed(SINK sink)
+{
+  Money removed_amount{ 0_USD };
+  std::size_t remaining_sorted_size = 0;
+
+  std::size_t output = 0;
+  for (std::size_t position = 0; statements_.size() != position; ++position)
+  {
+    auto & statement = statements_[position];
+    if (commit_states_.test(position))
+    {
+      removed_amount += statement.amount();
+      if (has_handles() && no_slot != position_slots_[position]) free_slot(position_slots_[position]);
+      sink(std::move(statement));
+    }
+    else
+    {
+      if (remaining_sorted_size == output && (0 == output || !(statement.date() < statements_[output - 1].date()))) ++remaining_sorted_size;
+      if (has_handles()) position_slots_[output] = position_slots_[position];
+      if (output != position) statements_[output] = std::move(statement);
+      ++output;
+    }
+  }
+
+  statements_.erase(statements_.begin() + output, statements_.end());
+  commit_states_ = SelectionBitmap(output); // only uncommitted statements remain.
+  if (has_handles())
+  {
+    position_slots_.resize(output);
+    update_handle_positions(0, output);
+  }
+  total_amount_ -= removed_amount;
+  sorted_size_ = remaining_sorted_size;
+  clear_journal();
+  reset_caches();
+  check_total_amount();
+
+  return removed_amount;
+}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::date_range io1::Listing<COMMITTABLE>::statements_between(QDate const & from, QDate const & to) const
+{
+  auto const & index = date_index();
+  auto const first = std::lower_bound(index.cbegin(), index.cend(), from, [this](std::uint32_t position, QDate const & date) { return statements_[position].date() < date; });
+  auto const last = std::upper_bound(first, index.cend(), to, [this](QDate const & date, std::uint32_t position) { return date < statements_[position].date(); });
+
+  return boost::make_iterator_range(boost::make_permutation_iterator(begin(), first), boost::make_permutation_iterator(begin(), last));
+}
+
+// Stale blocks are formatted one at a time, the first one along with the title. Up to date checksums are only read.
+template<typename COMMITTABLE> io1::BlockChecksums const & io1::Listing<COMMITTABLE>::block_checksums(HashAlgorithm algorithm, std::size_t block_size) const
+{
+  if (block_checksums_ && algorithm == block_checksums_->algorithm() && block_size == block_checksums_->block_size() && block_checksums_->is_up_to_date(statements_.size())) return *block_checksums_;
+
+  if (!block_checksums_ || algorithm != block_checksums_->algorithm() || block_size != block_checksums_->block_size()) block_checksums_.emplace(algorithm, block_size);
+  block_checksums_->resize(statements_.size());
+
+  std::string buffer;
+  for (std::size_t block = 0; block_checksums_->blocks().size() > block; ++block)
+  {
+    if (!block_checksums_->is_stale(block)) continue;
+
+    buffer.clear();
+    auto out = std::back_inserter(buffer);
+    if (0 == block) out = format_title_to(std::move(out));
+    auto const first = block_checksums_->first_statement(block);
+    out = format_statements_to(std::move(out), first, first + block_checksums_->blocks()[block].statement_count);
+    block_checksums_->set_block(block, buffer);
+  }
+
+  return *block_checksums_;
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::adopt_block_checksums(BlockChecksums checksums)
+{
+  block_checksums_.emplace(std::move(checksums));
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::build_caches(HashAlgorithm algorithm) const
+{
+  columns();
+  date_index();
+  block_checksums(algorithm);
+
+  return;
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::reset_caches(std::size_t first, std::size_t last)
+{
+  date_index_.reset();
+  return invalidate_statements(first, last);
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::invalidate_statements(std::size_t first, std::size_t last)
+{
+  columns_.reset();
+  if (block_checksums_) block_checksums_->invalidate(first, last);
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::rotate_commit_state(std::size_t from, std::size_t to)
+{
+  auto const committed = commit_states_.test(from);
+  if (from < to) for (auto position = from; to > position; ++position) commit_states_.assign(position, commit_states_.test(position + 1));
+  else for (auto position = from; to < position; --position) commit_states_.assign(position, commit_states_.test(position - 1));
+  commit_states_.assign(to, committed);
+}
+
+// Statements are usually appended in date order, in which case the index stays sorted. The others are merged in by the next query.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::append_to_date_index(const_iterator statement)
+{
+  assert(date_index_);
+  assert(end() - 1 == statement); // only appended statements can be added without shifting other positions.
+
+  auto const in_order = date_index_->size() == date_index_sorted_size_ && (date_index_->empty() || !(statement->date() < statements_[date_index_->back()].date()));
+  date_index_->push_back(static_cast<std::uint32_t>(statement - begin()));
+  if (in_order) ++date_index_sorted_size_;
+}
+
+// The appended positions follow every other one, a stable merge therefore keeps the statements of the same date in listing order.
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::date_index_type const & io1::Listing<COMMITTABLE>::date_index(void) const
+{
+  if (!date_index_)
+  {
+    date_index_.emplace(statements_.size());
+    std::iota(date_index_->begin(), date_index_->end(), 0);
+    if (!is_sorted()) std::stable_sort(date_index_->begin(), date_index_->end(), [this](std::uint32_t lhs, std::uint32_t rhs) { return statements_[lhs].date() < statements_[rhs].date(); });
+    date_index_sorted_size_ = date_index_->size();
+  }
+  merge_date_index();
+
+  return *date_index_;
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::merge_date_index(void) const
+{
+  if (!date_index_ || date_index_->size() == date_index_sorted_size_) return;
+
+  auto const by_date = [this](std::uint32_t lhs, std::uint32_t rhs) { return statements_[lhs].date() < statements_[rhs].date(); };
+  auto const middle = date_index_->begin() + static_cast<std::ptrdiff_t>(date_index_sorted_size_);
+  std::stable_sort(middle, date_index_->end(), by_date);
+  std::inplace_merge(date_index_->begin(), middle, date_index_->end(), by_date);
+  date_index_sorted_size_ = date_index_->size();
+}
+
+// Binary search on the date and then the position of the statement.
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::date_index_type::iterator io1::Listing<COMMITTABLE>::find_in_date_index(std::size_t position) const
+{
+  assert(date_index_ && date_index_->size() == date_index_sorted_size_);
+  auto const & date = statements_[position].date();
+
+  return std::lower_bound(date_index_->begin(), date_index_->end(), position, [this, &date](std::uint32_t other, std::size_t key)
+  {
+    auto const & other_date = statements_[other].date();
+    return (other_date < date) || (!(date < other_date) && other < key);
+  });
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::remove_from_date_index(std::size_t position)
+{
+  merge_date_index();
+  auto const entry = find_in_date_index(position);
+  assert(date_index_->end() != entry && position == *entry);
+
+  date_index_->erase(entry);
+  --date_index_sorted_size_;
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::insert_in_date_index(std::size_t position)
+{
+  date_index_->insert(find_in_date_index(position), static_cast<std::uint32_t>(position));
+  ++date_index_sorted_size_;
+}
+
+// Statements that shift together keep their order, and none crosses a statement outside of [first, last).
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::shift_date_index(std::size_t first, std::size_t last, std::ptrdiff_t offset)
+{
+  for (auto & position : *date_index_)
+    if (first <= position && last > position) position = static_cast<std::uint32_t>(static_cast<std::ptrdiff_t>(position) + offset);
+}
+
+template<typename COMMITTABLE> io1::StatementHandle io1::Listing<COMMITTABLE>::handle(const_iterator statement)
+{
+  assert(end() > statement);
+  if (!has_handles()) position_slots_.assign(statements_.size(), no_slot);
+
+  auto const position = static_cast<std::uint32_t>(statement - begin());
+  auto & slot = position_slots_[position];
+  if (no_slot == slot)
+  {
+    if (free_slots_.empty())
+    {
+      slot = static_cast<std::uint32_t>(slots_.size());
+      slots_.push_back({ position, 0 });
+    }
+    else
+    {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+      slots_[slot].position = position;
+    }
+  }
+
+  return StatementHandle{ slot, slots_[slot].generation };
+}
+
+// A released slot has a new generation, so a stale handle never matches it again.
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::const_iterator io1::Listing<COMMITTABLE>::resolve(StatementHandle handle) const
+{
+  if (slots_.size() <= handle.slot_) return end();
+
+  auto const & slot = slots_[handle.slot_];
+  if (handle.generation_ != slot.generation || no_slot == slot.position) return end(); // a parked slot waits for an undo.
+
+  assert(statements_.size() > slot.position);
+  return begin() + slot.position;
+}
+
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::statement_selection io1::Listing<COMMITTABLE>::resolve(handle_selection const & handles) const
+{
+  statement_selection selection;
+  selection.reserve(handles.size());
+  for (auto const handle : handles)
+  {
+    auto const statement = resolve(handle);
+    if (end() != statement) selection.insert(statement);
+  }
+
+  return selection;
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::release_handle(StatementHandle handle)
+{
+  auto const statement = resolve(handle);
+  if (end() == statement) return;
+
+  position_slots_[statement - begin()] = no_slot;
+  return free_slot(handle.slot_);
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::free_slot(std::uint32_t slot)
+{
+  slots_[slot].position = no_slot;
+  ++slots_[slot].generation;
+  free_slots_.push_back(slot);
+}
+
+// Frees the slots of the statements in [first, last), which are about to be replaced by inserted statements without handles.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::replace_handles(std::size_t first, std::size_t last, std::size_t inserted)
+{
+  if (!has_handles()) return;
+
+  for (auto const slot : boost::make_iterator_range(position_slots_.begin() + first, position_slots_.begin() + last))
+    if (no_slot != slot) free_slot(slot);
+
+  auto const replaced = std::min(last - first, inserted);
+  std::fill_n(position_slots_.begin() + first, replaced, no_slot);
+  if (inserted > replaced) position_slots_.insert(position_slots_.begin() + last, inserted - replaced, no_slot);
+  else position_slots_.erase(position_slots_.begin() + first + replaced, position_slots_.begin() + last);
+
+  return update_handle_positions(first, position_slots_.size());
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::update_handle_positions(std::size_t first, std::size_t last)
+{
+  for (auto position = first; last > position; ++position)
+  {
+    auto const slot = position_slots_[position];
+    if (no_slot != slot) slots_[slot].position = static_cast<std::uint32_t>(position);
+  }
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::set_journal_limit(std::size_t bytes)
+{
+  journal_limit_ = bytes;
+  if (0 == journal_limit_) return clear_journal();
+  return trim_journal();
+}
+
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::clear_journal(void)
+{
+  for (auto const & record : undo_records_) forget(record);
+  for (auto const & record : redo_records_) forget(record);
+  undo_records_.clear();
+  redo_records_.clear();
+  journal_size_ = 0;
+}
+
+// Applies the last recorded inverse and records its own inverse for redo.
+template<typename COMMITTABLE> bool io1::Listing<COMMITTABLE>::undo(void)
+{
+  if (undo_records_.empty()) return false;
+
+  auto record = std::move(undo_records_.back());
+  undo_records_.pop_back();
+  journal_size_ -= record_size(record);
+
+  redo_records_.push_back(replay(std::move(record)));
+  journal_size_ += record_size(redo_records_.back());
+  trim_journal();
+
+  return true;
+}
+
+template<typename COMMITTABLE> bool io1::Listing<COMMITTABLE>::redo(void)
+{
+  if (redo_records_.empty()) return false;
+
+  auto record = std::move(redo_records_.back());
+  redo_records_.pop_back();
+  journal_size_ -= record_size(record);
+
+  undo_records_.push_back(replay(std::move(record)));
+  journal_size_ += record_size(undo_records_.back());
+  trim_journal();
+
+  return true;
+}
+
+// Records the inverse of an edit, which makes the edits that were undone impossible to redo.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::journal(journal_record record)
+{
+  assert(journaling());
+  for (auto const & redo_record : redo_records_)
+  {
+    journal_size_ -= record_size(redo_record);
+    forget(redo_record);
+  }
+  redo_records_.clear();
+
+  journal_size_ += record_size(record);
+  undo_records_.push_back(std::move(record));
+  return trim_journal();
+}
+
+// The replaced statements are still at position, along with their commit states and their handles. A single statement replaced by
+// others hands its handle over to the first of them, the handles of erased and grouped statements are parked in the record instead
+// of being freed, so that undoing the edit gives them back.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::journal_replacement(std::size_t position, std::size_t count, vector_type replaced)
+{
+  SelectionBitmap commit_states(replaced.size());
+  for (std::size_t i = 0; replaced.size() > i; ++i) if (commit_states_.test(position + i)) commit_states.set(i);
+
+  auto const keeps_handle = (1 == replaced.size() && 0 != count);
+  splice_record record{ position, count, std::move(replaced), std::move(commit_states), {}, keeps_handle };
+  if (has_handles() && !record.keeps_handle)
+  {
+    record.slots.assign(record.statements.size(), no_slot);
+    for (std::size_t i = 0; record.statements.size() > i; ++i)
+    {
+      std::swap(record.slots[i], position_slots_[position + i]);
+      if (no_slot != record.slots[i]) slots_[record.slots[i]].position = no_slot;
+    }
+  }
+
+  return journal(std::move(record));
+}
+
+// Forgets the oldest edits until the journal fits in its limit, redo records are dropped last.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::trim_journal(void)
+{
+  while (journal_limit_ < journal_size_ && !undo_records_.empty())
+  {
+    journal_size_ -= record_size(undo_records_.front());
+    forget(undo_records_.front());
+    undo_records_.pop_front();
+  }
+  while (journal_limit_ < journal_size_ && !redo_records_.empty())
+  {
+    journal_size_ -= record_size(redo_records_.front());
+    forget(redo_records_.front());
+    redo_records_.erase(redo_records_.begin());
+  }
+}
+
+// The statements of the record will never come back, their handles become stale.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::forget(journal_record const & record)
+{
+  if (auto const * splice = std::get_if<splice_record>(&record))
+    for (auto const slot : splice->slots) if (no_slot != slot) free_slot(slot);
+}
+
+// Counts the statements, the composed entries and the descriptions, but not the caches.
+template<typename COMMITTABLE> std::size_t io1::Listing<COMMITTABLE>::memory_usage(void) const
+{
+  return boost::accumulate(statements_, statements_.capacity() * sizeof(statement_type) + commit_states_.words().capacity() * sizeof(SelectionBitmap::word_type), [](std::size_t size, statement_type const & statement) { return size + owned_memory(statement); });
+}
+
+// The main entry lives in the statement, composed entries are on the heap. Descriptions count their capacity.
+template<typename COMMITTABLE> std::size_t io1::Listing<COMMITTABLE>::owned_memory(statement_type const & statement)
+{
+  auto size = statement.main_entry().description().capacity();
+  for (auto const & entry : statement.composed_entries()) size += sizeof(Entry) + entry.description().capacity();
+
+  return size;
+}
+
+// Counts the statements objects along with the entries and the text they own.
+template<typename COMMITTABLE> std::size_t io1::Listing<COMMITTABLE>::record_size(journal_record const & record)
+{
+  auto const * splice = std::get_if<splice_record>(&record);
+  if (!splice) return sizeof(journal_record);
+
+  auto const fixed_size = sizeof(journal_record) + splice->statements.capacity() * sizeof(statement_type) + splice->commit_states.words().capacity() * sizeof(SelectionBitmap::word_type) + splice->slots.capacity() * sizeof(std::uint32_t);
+  return boost::accumulate(splice->statements, fixed_size, [](std::size_t size, statement_type const & statement) { return size + owned_memory(statement); });
+}
+
+// Applies a record with the editing primitives and returns its inverse.
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::journal_record io1::Listing<COMMITTABLE>::replay(journal_record record)
+{
+  replaying_ = true;
+  auto inverse = std::visit([this](auto & edit) -> journal_record
+  {
+    using edit_type = std::decay_t<decltype(edit)>;
+    if constexpr (std::is_same_v<edit_type, move_record>)
+    {
+      move_statement(begin() + edit.from, begin() + edit.to);
+      return move_record{ edit.to, edit.from };
+    }
+    else if constexpr (std::is_same_v<edit_type, swap_record>)
+    {
+      swap_statements(begin() + edit.position1, begin() + edit.position2);
+      return edit;
+    }
+    else return splice(std::move(edit));
+  }, record);
+  replaying_ = false;
+
+  return inverse;
+}
+
+// Replaces count statements at position by the statements of the record and returns the replaced ones. The tail is shifted at most once.
+template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::splice_record io1::Listing<COMMITTABLE>::splice(splice_record record)
+{
+  auto const position = record.position;
+  auto const count = record.count;
+  auto & statements = record.statements;
+  assert(statements_.size() >= position + count);
+  assert(statements.size() == record.commit_states.size());
+
+  auto const first = statements_.begin() + position;
+  splice_record inverse{ position, statements.size(), vector_type(std::make_move_iterator(first), std::make_move_iterator(first + count)), SelectionBitmap(count), {}, record.keeps_handle };
+  for (std::size_t i = 0; count > i; ++i) if (commit_states_.test(position + i)) inverse.commit_states.set(i);
+
+  for (auto const & statement : inverse.statements) total_amount_ -= statement.amount();
+  for (auto const & statement : statements) total_amount_ += statement.amount();
+  truncate_sorted_prefix(begin() + position);
+  splice_handles(record, inverse);
+  if (count != statements.size()) reset_caches(position);
+  else reset_caches(position, position + count);
+
+  auto const common = std::min(count, statements.size());
+  std::move(statements.begin(), statements.begin() + common, first);
+  if (count > common)
+  {
+    statements_.erase(first + common, first + count);
+    commit_states_.erase(position + common, position + count);
+  }
+  else
+  {
+    statements_.insert(first + common, std::make_move_iterator(statements.begin() + common), std::make_move_iterator(statements.end()));
+    commit_states_.insert(position + common, statements.size() - common, false);
+  }
+  for (std::size_t i = 0; statements.size() > i; ++i) commit_states_.assign(position + i, record.commit_states.test(i));
+  check_total_amount();
+
+  return inverse;
+}
+
+// A statement that keeps its handle stays in its slot, the others swap the slots parked in the record for the ones in the listing.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::splice_handles(splice_record const & record, splice_record & inverse)
+{
+  std::size_t const kept = record.keeps_handle ? 1 : 0;
+  assert(!record.keeps_handle || (0 != record.count && !record.statements.empty()));
+
+  auto const restores_handles = std::any_of(record.slots.begin(), record.slots.end(), [](std::uint32_t slot) { return no_slot != slot; });
+  if (!has_handles() && !restores_handles) return;
+  if (!has_handles()) position_slots_.assign(statements_.size(), no_slot);
+
+  auto const first = position_slots_.begin() + static_cast<std::ptrdiff_t>(record.position);
+  inverse.slots.assign(record.count, no_slot);
+  std::copy(first + kept, first + record.count, inverse.slots.begin() + kept);
+  for (auto const slot : inverse.slots) if (no_slot != slot) slots_[slot].position = no_slot;
+
+  auto const inserted = position_slots_.erase(first + kept, first + record.count);
+  if (record.slots.empty()) position_slots_.insert(inserted, record.statements.size() - kept, no_slot);
+  else position_slots_.insert(inserted, record.slots.begin() + kept, record.slots.end());
+
+  return update_handle_positions(record.position, position_slots_.size());
+}
+
+template<typename COMMITTABLE> std::size_t io1::Listing<COMMITTABLE>::sorted_prefix_size(void) const
+{
+  return static_cast<std::size_t>(std::is_sorted_until(statements_.begin(), statements_.end(), sort_predicate<statement_type>) - statements_.begin());
+}
+
+// Summing the statements after every edit would make adding n statements quadratic, checking once every size() edits keeps each edit constant in amortized time.
+template<typename COMMITTABLE> void io1::Listing<COMMITTABLE>::check_total_amount(void) const
+{
+#ifndef NDEBUG
+  if (statements_.size() > ++unchecked_edits_) return;
+  unchecked_edits_ = 0;
+
+  auto const actual_total_amount = boost::accumulate(statements_, 0_USD, [](Money total, statement_type const & statement) { return total += statement.amount(); });
+  assert(actual_total_amount == total_amount_);
+#endif
 }
 
 template<typename COMMITTABLE> typename io1::Listing<COMMITTABLE>::vector_type::iterator io1::Listing<COMMITTABLE>::remove_const(const_iterator statement)
 {
-  return statements_.erase(statement,statement);
+  return statements_.erase(to_vector_iterator(statement),to_vector_iterator(statement));
+}
+
+io1::CommittableStatementReference io1::CommittableStatementIterator::dereference(void) const
+{
+  return CommittableStatementReference(*statement_, *listing_, static_cast<std::size_t>(statement_ - listing_->begin().base()));
+}
+
+bool io1::CommittableStatementReference::is_committed(void) const
+{
+  return listing_->committed_statements().test(position_);
+}
+
+// The commit state of the statements of a listing is editable through their const references, as it used to be held by the statements.
+void io1::CommittableStatementReference::set_committed(bool committed) const
+{
+  const_cast<Listing<committable_tag> *>(listing_)->set_committed(listing_->begin() + position_, committed);
+}
+
+std::ostream & io1::CommittableStatementReference::write(std::ostream & stream) const
+{
+  std::string buffer;
+  format_to(std::back_inserter(buffer));
+
+  return stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 namespace io1
@@ -0,0 +1,140 @@
+/// \file listing_columns.cpp
+#include "io1/listing_columns.hpp"
+#include "io1/running_balance.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+// Appends the main entry of a statement.
+void io1::ListingColumns::push_back(Entry const & main_entry, bool committed)
+{
+  auto const position = size();
+  if (0 == position % word_bits) committed_.push_back(0);
+  committed_.back() |= word_type{ committed } << (position % word_bits);
+
+  days_.push_back(to_day(main_entry.date()));
+  amounts_.push_back(main_entry.amount().data());
+
+  descriptions_ += main_entry.description();
+  assert(std::numeric_limits<std::uint32_t>::max() >= descriptions_.size());
+  description_offsets_.push_back(static_cast<std::uint32_t>(descriptions_.size()));
+}
+
+// Changes the commit state of a statement in place.
+void io1::ListingColumns::set_committed(std::size_t position, bool committed)
+{
+  assert(size() > position);
+  auto const mask = word_type{ 1 } << (position % word_bits);
+  if (committed) committed_[position / word_bits] |= mask;
+  else committed_[position / word_bits] &= ~mask;
+}
+
+// Reserves memory for size statements, descriptions excepted.
+void io1::ListingColumns::reserve(std::size_t size)
+{
+  days_.reserve(size);
+  amounts_.reserve(size);
+  committed_.reserve((size + word_bits - 1) / word_bits);
+  description_offsets_.reserve(size + 1);
+}
+
+// Removes all statements.
+void io1::ListingColumns::clear(void)
+{
+  days_.clear();
+  amounts_.clear();
+  committed_.clear();
+  description_offsets_.resize(1);
+  descriptions_.clear();
+}
+
+// Returns the description of a statement.
+std::string_view io1::ListingColumns::description(std::size_t position) const
+{
+  assert(size() > position);
+  auto const begin = description_offsets_[position];
+  return std::string_view(descriptions_).substr(begin, description_offsets_[position + 1] - begin);
+}
+
+// Converts a date into a number of days since 1970-01-01.
+io1::ListingColumns::day_type io1::ListingColumns::to_day(std::chrono::year_month_day const & date)
+{
+  return static_cast<day_type>(std::chrono::sys_days{ date }.time_since_epoch().count());
+}
+
+// Converts a number of days since 1970-01-01 into a date.
+std::chrono::year_month_day io1::ListingColumns::to_date(day_type day)
+{
+  return std::chrono::year_month_day{ std::chrono::sys_days{ std::chrono::days{ day } } };
+}
+
+// Returns the total amount. The loop has no dependency but the accumulator and is vectorized.
+io1::Money io1::ListingColumns::sum(void) const
+{
+  return Money{ std::reduce(amounts_.begin(), amounts_.end(), amount_type{ 0 }) };
+}
+
+// Returns the total amount of the statements dated within [from, to].
+io1::Money io1::ListingColumns::sum(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const
+{
+  auto const first = to_day(from);
+  auto const last = to_day(to);
+
+  // branchless so that the compiler can turn the condition into a mask.
+  amount_type total = 0;
+  for (std::size_t i = 0; size() > i; ++i)
+    total += ((first <= days_[i]) & (days_[i] <= last)) ? amounts_[i] : 0;
+
+  return Money{ total };
+}
+
+// Returns the smallest and the largest amount.
+std::pair<io1::Money, io1::Money> io1::ListingColumns::minmax_amount(void) const
+{
+  assert(!empty());
+  auto const [min, max] = std::minmax_element(amounts_.begin(), amounts_.end());
+  return { Money{ *min }, Money{ *max } };
+}
+
+// Returns the earliest and the latest day number.
+std::pair<io1::ListingColumns::day_type, io1::ListingColumns::day_type> io1::ListingColumns::minmax_day(void) const
+{
+  assert(!empty());
+  auto const [min, max] = std::minmax_element(days_.begin(), days_.end());
+  return { *min, *max };
+}
+
+// Returns the positions of the statements dated within [from, to].
+std::vector<std::uint32_t> io1::ListingColumns::filter(std::chrono::year_month_day const & from, std::chrono::year_month_day const & to) const
+{
+  auto const first = to_day(from);
+  auto const last = to_day(to);
+
+  // write unconditionally and only advance the output on a match, which avoids mispredicted branches.
+  std::vector<std::uint32_t> positions(size());
+  std::size_t count = 0;
+  for (std::size_t i = 0; size() > i; ++i)
+  {
+    positions[count] = static_cast<std::uint32_t>(i);
+    count += ((first <= days_[i]) & (days_[i] <= last));
+  }
+
+  positions.resize(count);
+  return positions;
+}
+
+// Returns the number of committed statements.
+std::size_t io1::ListingColumns::committed_count(void) const
+{
+  return std::accumulate(committed_.begin(), committed_.end(), std::size_t{ 0 }, [](std::size_t count, word_type word) { return count + static_cast<std::size_t>(std::popcount(word)); });
+}
+
+// Returns the balance after each statement.
+std::vector<io1::ListingColumns::amount_type> io1::ListingColumns::running_balances(Money initial_balance) const
+{
+  std::vector<amount_type> balances(size());
+  running_balance(amounts_, initial_balance.data(), balances);
+  return balances;
+}
@@ -0,0 +1,98 @@
+/// \file running_balance.cpp
+#include "io1/running_balance.hpp"
+#include <cassert>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define IO1_RUNNING_BALANCE_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define IO1_TARGET_AVX2
+#else
+#define IO1_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+  static_assert(8 == sizeof(io1::balance_type), "The vectorized kernel works on 64 bits amounts.");
+
+  using kernel_type = void (*)(io1::balance_type const *, std::size_t, io1::balance_type, io1::balance_type *);
+
+  void running_balance_scalar_kernel(io1::balance_type const * amounts, std::size_t count, io1::balance_type balance, io1::balance_type * balances)
+  {
+    for (std::size_t i = 0; count > i; ++i) balances[i] = balance += amounts[i];
+  }
+
+#ifdef IO1_RUNNING_BALANCE_AVX2
+  // Computes the prefix sum of four amounts at a time with two shift and add steps (Hillis-Steele),
+  // then adds the balance carried from the previous block.
+  IO1_TARGET_AVX2 void running_balance_avx2_kernel(io1::balance_type const * amounts, std::size_t count, io1::balance_type balance, io1::balance_type * balances)
+  {
+    auto const zero = _mm256_setzero_si256();
+    auto carry = _mm256_set1_epi64x(balance);
+
+    std::size_t i = 0;
+    for (; count >= i + 4; i += 4)
+    {
+      auto sums = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(amounts + i));
+      sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_permute4x64_epi64(sums, _MM_SHUFFLE(2, 1, 0, 3)), zero, 0x03)); // [a0, a0+a1, a1+a2, a2+a3]
+      sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_permute4x64_epi64(sums, _MM_SHUFFLE(1, 0, 3, 2)), zero, 0x0F)); // [a0, a0+a1, a0+a1+a2, a0+a1+a2+a3]
+      sums = _mm256_add_epi64(sums, carry);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(balances + i), sums);
+      carry = _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    if (0 != i) balance = balances[i - 1];
+    running_balance_scalar_kernel(amounts + i, count - i, balance, balances + i);
+  }
+
+  bool has_avx2(void)
+  {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool const os_saves_ymm = (info[2] & (1 << 27)) && (6 == (_xgetbv(0) & 6)); // OSXSAVE and the OS saves the XMM and YMM registers.
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+  }
+#endif
+
+  kernel_type select_kernel(void)
+  {
+#ifdef IO1_RUNNING_BALANCE_AVX2
+    if (has_avx2()) return &running_balance_avx2_kernel;
+#endif
+    return &running_balance_scalar_kernel;
+  }
+
+  kernel_type selected_kernel(void)
+  {
+    static kernel_type const kernel = select_kernel();
+    return kernel;
+  }
+}
+
+// Computes the running balance with the best kernel available.
+void io1::running_balance(std::span<balance_type const> amounts, balance_type initial_balance, std::span<balance_type> balances)
+{
+  assert(balances.size() >= amounts.size());
+  return selected_kernel()(amounts.data(), amounts.size(), initial_balance, balances.data());
+}
+
+// Computes the running balance one amount at a time.
+void io1::running_balance_scalar(std::span<balance_type const> amounts, balance_type initial_balance, std::span<balance_type> balances)
+{
+  assert(balances.size() >= amounts.size());
+  return running_balance_scalar_kernel(amounts.data(), amounts.size(), initial_balance, balances.data());
+}
+
+// Returns true if the AVX2 kernel was selected.
+bool io1::running_balance_uses_avx2(void)
+{
+  return &running_balance_scalar_kernel != selected_kernel();
+}
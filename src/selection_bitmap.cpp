@@ -0,0 +1,132 @@
+/// \file selection_bitmap.cpp
+#include "io1/selection_bitmap.hpp"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+// Selects every statement, the bits past the last statement are left cleared.
+void io1::SelectionBitmap::set_all(void)
+{
+  std::fill(words_.begin(), words_.end(), ~word_type{ 0 });
+  if (auto const remainder = size_ % word_bits; 0 != remainder) words_.back() = (word_type{ 1 } << remainder) - 1;
+}
+
+void io1::SelectionBitmap::clear(void)
+{
+  std::fill(words_.begin(), words_.end(), word_type{ 0 });
+}
+
+// Flips whole words, then clears the bits past the last statement.
+void io1::SelectionBitmap::flip(void)
+{
+  for (auto & word : words_) word = ~word;
+  if (auto const remainder = size_ % word_bits; 0 != remainder) words_.back() &= (word_type{ 1 } << remainder) - 1;
+}
+
+void io1::SelectionBitmap::push_back(bool selected)
+{
+  if (0 == size_ % word_bits) words_.push_back(0);
+  if (selected) words_.back() |= mask(size_);
+  ++size_;
+}
+
+// The following statements are shifted first, then the inserted ones are selected or unselected.
+void io1::SelectionBitmap::insert(std::size_t position, std::size_t count, bool selected)
+{
+  assert(size_ >= position);
+  auto const tail = size_ - position;
+  size_ += count;
+  words_.resize((size_ + word_bits - 1) / word_bits, 0);
+
+  move_bits(position, position + count, tail);
+  for (auto last = position + count; last > position; ++position) assign(position, selected);
+}
+
+// The following statements are shifted over the erased ones, the bits left past the new size are cleared.
+void io1::SelectionBitmap::erase(std::size_t first, std::size_t last)
+{
+  assert(first <= last && size_ >= last);
+  move_bits(last, first, size_ - last);
+
+  size_ -= last - first;
+  words_.resize((size_ + word_bits - 1) / word_bits);
+  clear_tail();
+}
+
+// Counts the selected statements one word at a time.
+std::size_t io1::SelectionBitmap::count(void) const
+{
+  return std::accumulate(words_.begin(), words_.end(), std::size_t{ 0 }, [](std::size_t count, word_type word) { return count + static_cast<std::size_t>(std::popcount(word)); });
+}
+
+bool io1::SelectionBitmap::none(void) const
+{
+  return std::all_of(words_.begin(), words_.end(), [](word_type word) { return 0 == word; });
+}
+
+// Skips empty words, then locates the bit with countr_zero.
+std::size_t io1::SelectionBitmap::find_next(std::size_t position) const
+{
+  if (size_ <= position) return size_;
+
+  auto index = position / word_bits;
+  auto word = words_[index] & (~word_type{ 0 } << (position % word_bits));
+  while (0 == word)
+  {
+    if (words_.size() == ++index) return size_;
+    word = words_[index];
+  }
+
+  return index * word_bits + static_cast<std::size_t>(std::countr_zero(word));
+}
+
+// Skips empty words from the end, then locates the bit with countl_zero.
+std::size_t io1::SelectionBitmap::find_last(void) const
+{
+  for (auto index = words_.size(); 0 != index--;)
+  {
+    if (0 != words_[index]) return index * word_bits + word_bits - 1 - static_cast<std::size_t>(std::countl_zero(words_[index]));
+  }
+
+  return size_;
+}
+
+// Reads the 64 bits from position on, across two words when position is not aligned.
+io1::SelectionBitmap::word_type io1::SelectionBitmap::load(std::size_t position) const
+{
+  auto const index = position / word_bits;
+  auto const shift = position % word_bits;
+  if (words_.size() <= index) return 0;
+
+  auto word = words_[index] >> shift;
+  if (0 != shift && words_.size() > index + 1) word |= words_[index + 1] << (word_bits - shift);
+  return word;
+}
+
+// Bits are copied bit by bit until the destination is aligned on a word, then a word at a time. Moving towards the end copies
+// from the last bits backwards, so that no bit is overwritten before it is read.
+void io1::SelectionBitmap::move_bits(std::size_t from, std::size_t to, std::size_t count)
+{
+  if (from == to || 0 == count) return;
+
+  if (to < from)
+  {
+    std::size_t i = 0;
+    for (; count > i && 0 != (to + i) % word_bits; ++i) assign(to + i, test(from + i));
+    for (; count - i >= word_bits; i += word_bits) words_[(to + i) / word_bits] = load(from + i);
+    for (; count > i; ++i) assign(to + i, test(from + i));
+  }
+  else
+  {
+    auto i = count;
+    for (; 0 < i && 0 != (to + i) % word_bits; --i) assign(to + i - 1, test(from + i - 1));
+    for (; word_bits <= i; i -= word_bits) words_[(to + i) / word_bits - 1] = load(from + i - word_bits);
+    for (; 0 < i; --i) assign(to + i - 1, test(from + i - 1));
+  }
+}
+
+// Keeps the bits past the last statement cleared, so that whole words can be counted and compared.
+void io1::SelectionBitmap::clear_tail(void)
+{
+  if (auto const remainder = size_ % word_bits; 0 != remainder) words_.back() &= (word_type{ 1 } << remainder) - 1;
+}
@@ -2,7 +2,7 @@
 #include "io1/statement.hpp"
 #include <iostream>
 #include <iomanip>
-#include <cstring>
+#include <iterator>
 
 #include <boost/format.hpp>
 #include <boost/exception/get_error_info.hpp>
@@ -12,12 +12,6 @@
 
 #include "blank.hpp"
 
-namespace
-{
-  auto const composed_char = '-';
-  auto const committed_char = '#';
-}
-
 // Constructor from an amount and a description.
 io1::Statement::Statement(Money amount, QString const & description)
 :Statement(Entry{std::move(amount),description})
@@ -30,11 +24,19 @@ io1::Statement::Statement(Money amount, QString const & description, QDate date)
 
 // Constructor from an entry.
 io1::Statement::Statement(Entry entry)
-:entries_(1,std::move(entry))
 {
+  entries_.push_back(std::move(entry)); // constructing entries_ with a count and a value would copy the entry.
   assert(1 == entries_.size());
 }
 
+// Constructor from the main entry followed by the composed entries.
+io1::Statement::Statement(std::span<Entry const> entries)
+:entries_(entries.begin(), entries.end())
+{
+  assert(!entries_.empty());
+  assert(2 != entries_.size()); // a statement is either a single entry or composed of at least two entries.
+}
+
 // Returns a range over the composed entries.
 io1::Statement::const_range io1::Statement::composed_entries(void) const
 {
@@ -53,15 +55,10 @@ std::ostream & io1::Statement::write_impl(std::ostream & stream, char const * pr
 {
   assert(prefix);
 
-  stream << prefix << entries_.front();
-  auto const padding = std::string(std::strlen(prefix),' ');
-
-  for (auto const & composed_entry : composed_entries())
-  {
-    stream << padding << composed_char << ' ' << composed_entry;
-  }
+  std::string buffer;
+  format_to(std::back_inserter(buffer), prefix);
 
-  return stream;
+  return stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 // Reads a generic statement (either Statement or CommittableStatement) from a stream.
@@ -92,6 +89,40 @@ io1::Statement io1::Statement::read(std::istream & stream)
   return read_impl<Statement>(stream);
 }
 
+// Reads a generic statement (either Statement or CommittableStatement) from the beginning of a buffer, as read_impl does from a stream.
+template<typename STATEMENT> std::size_t io1::Statement::read_impl(std::string_view buffer, STATEMENT & statement)
+{
+  Entry main_entry;
+  auto position = Entry::read(buffer, main_entry);
+
+  auto amount = main_entry.amount();
+
+  std::vector<Entry> entries;
+  for (auto next = buffer.find_first_not_of(" \t", position); std::string_view::npos != next && composed_char == buffer[next]; next = buffer.find_first_not_of(" \t", position))
+  {
+    position = next + 1; // consume the composed char
+    position += Entry::read(buffer.substr(position), entries.emplace_back());
+    amount -= entries.back().amount();
+  }
+
+  if (entries.empty())
+  {
+    statement = STATEMENT{ std::move(main_entry) };
+    return position;
+  }
+
+  if (0_USD != amount) BOOST_THROW_EXCEPTION(AmountMismatch{} << AmountMismatch::errinfo_main_entry{ std::move(main_entry) } << AmountMismatch::errinfo_entry_list{ std::move(entries) });
+
+  statement = STATEMENT{ main_entry.description(),main_entry.date(),std::move(entries) };
+  return position;
+}
+
+// Reads a statement from a buffer.
+std::size_t io1::Statement::read(std::string_view buffer, Statement & statement)
+{
+  return read_impl(buffer, statement);
+}
+
 
 // Constructs an AmountMismatch exception.
 void io1::AmountMismatch::format_message(void) const
@@ -122,28 +153,54 @@ bool io1::Statement::equals(Statement const & rhs) const
 // Formats a committable statement in a stream.
 std::ostream & io1::CommittableStatement::write(std::ostream & stream) const
 {
-  char const prefix[3] = { committed_char, ' ', '\0' };
-  return write_impl(stream, is_committed() ? prefix : "  ");
+  std::string buffer;
+  format_to(std::back_inserter(buffer));
+
+  return stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 // Reads a committable statement from a stream.
 io1::CommittableStatement io1::CommittableStatement::read(std::istream & stream)
 {
-  stream >> std::ws;
-  
   bool committed = false;
-  if (committed_char == stream.peek())
-  {
-    committed = true;
-    stream.ignore(); // consume the committed char
-  }
-
-  auto statement = Statement::read_impl<CommittableStatement>(stream);
+  CommittableStatement statement{ read(stream, committed) };
   statement.set_committed(committed);
-  
+
   return statement;
 }
 
+// Reads a committable statement from a buffer.
+std::size_t io1::CommittableStatement::read(std::string_view buffer, CommittableStatement & statement)
+{
+  bool committed = false;
+  auto const position = read(buffer, statement, committed);
+  statement.set_committed(committed);
+
+  return position;
+}
+
+// Reads a statement and its commit state from a stream.
+io1::Statement io1::CommittableStatement::read(std::istream & stream, bool & committed)
+{
+  stream >> std::ws;
+
+  committed = (committed_char == stream.peek());
+  if (committed) stream.ignore(); // consume the committed char
+
+  return Statement::read_impl<Statement>(stream);
+}
+
+// Reads a statement and its commit state from a buffer.
+std::size_t io1::CommittableStatement::read(std::string_view buffer, Statement & statement, bool & committed)
+{
+  auto position = std::min(buffer.find_first_not_of(" \t\r\n"), buffer.size());
+
+  committed = (position < buffer.size() && committed_char == buffer[position]);
+  if (committed) ++position; // consume the committed char
+
+  return position + read_impl(buffer.substr(position), statement);
+}
+
 // Returns true if lhs and rhs are equal.
 bool io1::operator==(CommittableStatement const & lhs, CommittableStatement const & rhs)
 {
@@ -1,6 +1,14 @@
 /// \file test_account.cpp
 #include "gtest/gtest.h"
 #include "account.hpp"
+#include "accounting_exception.hpp"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/exception/get_error_info.hpp>
+#include <sstream>
+#include <iterator>
+#include <string>
 
 namespace io1 {
 
@@ -8,9 +16,19 @@ namespace io1 {
   {
   public:
     void TestInteraction(void) const;
+    void TestArchive(void) const;
+    void TestStreamedArchive(void) const;
+    void TestOpen(void) const;
+    void TestHashAlgorithm(void) const;
+    void TestBlockLayout(void) const;
   };
 
   TEST_F(TestAccount, TestInteraction) { return TestInteraction(); };
+  TEST_F(TestAccount, TestArchive) { return TestArchive(); };
+  TEST_F(TestAccount, TestStreamedArchive) { return TestStreamedArchive(); };
+  TEST_F(TestAccount, TestOpen) { return TestOpen(); };
+  TEST_F(TestAccount, TestHashAlgorithm) { return TestHashAlgorithm(); };
+  TEST_F(TestAccount, TestBlockLayout) { return TestBlockLayout(); };
 }
 
 void io1::TestAccount::TestInteraction(void) const
@@ -32,3 +50,241 @@ void io1::TestAccount::TestInteraction(void) const
   std::cout << a;
   return;
 }
+
+void io1::TestAccount::TestArchive(void) const
+{
+  boost::filesystem::remove("test_archive.lst");
+  boost::filesystem::remove("test_archive_2.lst");
+
+  Account a{ 100_USD, QDate{ 2020,1,1 } };
+  auto & listing = a.current_listing();
+  listing.add_statement(20_USD, "second deposit", QDate{ 2020,1,3 });
+  listing.add_statement(-5_USD, "withdrawal", QDate{ 2020,1,2 });
+  listing.add_statement(-7_USD, "pending withdrawal", QDate{ 2020,1,4 });
+  listing.set_committed(listing.begin() + 1);
+  listing.set_committed(listing.begin() + 2);
+
+  a.archive("test_archive");
+
+  // the committed statements are archived, sorted by date, and the balance does not change.
+  ASSERT_EQ(1, a.archived_listings().size());
+  ASSERT_EQ(115_USD, a.archived_balance());
+  ASSERT_EQ(108_USD, a.balance());
+  ASSERT_EQ(1, a.current_listing().statements().size());
+  ASSERT_EQ(-7_USD, a.current_listing().begin()->amount());
+
+  auto const archived = a.archived_listing(0);
+  ASSERT_EQ(3, archived->statements().size());
+  ASSERT_TRUE(archived->is_sorted());
+  ASSERT_EQ(115_USD, archived->total_amount());
+
+  // the listing of the new archive is held by the cache.
+  ASSERT_EQ(1, a.archive_cache().size());
+  ASSERT_EQ(1, a.archive_cache().statistics().hits);
+
+  // nothing left to archive.
+  a.archive("test_archive");
+  ASSERT_EQ(1, a.archived_listings().size());
+
+  // the current listing is left untouched when the archive cannot be written.
+  listing.set_committed(listing.begin());
+  ASSERT_ANY_THROW(a.archive("missing_directory/test_archive"));
+  ASSERT_EQ(1, a.archived_listings().size());
+  ASSERT_EQ(1, a.current_listing().statements().size());
+  ASSERT_TRUE(a.current_listing().is_committed(a.current_listing().begin()));
+  ASSERT_EQ(108_USD, a.balance());
+
+  // the cache releases the listings of archives that no longer fit its budget, they are read again from their files.
+  a.archive("test_archive_2");
+  ASSERT_EQ(2, a.archive_cache().size());
+  a.archive_cache().set_memory_budget(0);
+  ASSERT_EQ(1, a.archive_cache().size());
+  ASSERT_FALSE(a.archived_listings().front().is_loaded());
+  ASSERT_TRUE(a.archived_listings().back().is_loaded());
+  ASSERT_EQ(3, a.archived_listing(0)->statements().size());
+  ASSERT_EQ(108_USD, a.balance());
+
+  boost::filesystem::remove("test_archive.lst");
+  boost::filesystem::remove("test_archive_2.lst");
+  return;
+}
+
+void io1::TestAccount::TestStreamedArchive(void) const
+{
+  boost::filesystem::remove("test_streamed_archive.lst");
+
+  Account a{ 100_USD, QDate{ 2020,1,1 } };
+  auto & listing = a.current_listing();
+  for (int i = 0; 100 > i; ++i) listing.set_committed(listing.add_statement(1_USD, "deposit", QDate{ 2020,3,1 }.addDays(-i)));
+  listing.add_statement(-7_USD, "pending withdrawal", QDate{ 2020,1,4 });
+
+  a.archive("test_streamed_archive", 256);
+
+  // the archive only keeps its balance, the statements are read back from the file.
+  ASSERT_EQ(1, a.archived_listings().size());
+  ASSERT_EQ(200_USD, a.archived_balance());
+  ASSERT_EQ(193_USD, a.balance());
+  ASSERT_EQ(1, a.current_listing().statements().size());
+  ASSERT_EQ(0, a.current_listing().committed_count());
+
+  auto const archived = a.archived_listing(0);
+  ASSERT_EQ(101, archived->statements().size());
+  ASSERT_TRUE(archived->is_sorted());
+  ASSERT_EQ(200_USD, archived->total_amount());
+  ASSERT_EQ(1, a.archive_cache().statistics().misses);
+  ASSERT_EQ(archived, a.archived_listing(0));
+  ASSERT_EQ(1, a.archive_cache().statistics().hits);
+
+  // the current listing is left untouched when the archive cannot be written.
+  listing.set_committed(listing.begin());
+  ASSERT_ANY_THROW(a.archive("test_streamed_archive", 256));
+  ASSERT_EQ(1, a.current_listing().statements().size());
+
+  boost::filesystem::remove("test_streamed_archive.lst");
+  return;
+}
+
+// Whatever the verification mode, a damaged archive is reported, only later when verification is deferred.
+void io1::TestAccount::TestOpen(void) const
+{
+  for (auto const filename : { "test_open.act", "test_open.lst", "test_open_0.lst", "test_open_1.lst" }) boost::filesystem::remove(filename);
+
+  {
+    Account a{ 100_USD, QDate{ 2020,1,1 } };
+    a.set_name("test_open");
+    auto & listing = a.current_listing();
+    for (int i = 0; 10 > i; ++i) listing.set_committed(listing.add_statement(1_USD, "deposit", QDate{ 2020,2,1 }.addDays(i)));
+    a.archive("test_open_0", 1024);
+    for (int i = 0; 10 > i; ++i) listing.set_committed(listing.add_statement(2_USD, "deposit", QDate{ 2020,3,1 }.addDays(i)));
+    a.archive("test_open_1", 1024);
+    listing.add_statement(-7_USD, "pending withdrawal", QDate{ 2020,4,1 });
+
+    save_as("test_open.act", a);
+  }
+
+  using verification_type = OpenOptions::verification_type;
+  for (auto const verification : { verification_type::serial, verification_type::parallel, verification_type::deferred })
+  {
+    auto const a = open("test_open.act", { verification, 2 });
+    ASSERT_EQ(2, a.archived_listings().size());
+    ASSERT_EQ(130_USD, a.archived_balance());
+    ASSERT_EQ(123_USD, a.balance());
+    ASSERT_EQ(10, a.archived_listing(1)->statements().size());
+  }
+
+  boost::filesystem::ofstream("test_open_0.lst", std::ios::app) << '\n';
+
+  ASSERT_THROW(open("test_open.act", { verification_type::serial }), FileReadError);
+  ASSERT_THROW(open("test_open.act", { verification_type::parallel, 2 }), FileReadError);
+
+  auto const a = open("test_open.act", { verification_type::deferred });
+  ASSERT_NO_THROW(a.archived_listing(1));
+  ASSERT_THROW(a.archived_listing(0), CorruptedFile);
+
+  for (auto const filename : { "test_open.act", "test_open.lst", "test_open_0.lst", "test_open_1.lst" }) boost::filesystem::remove(filename);
+  return;
+}
+
+// The algorithm is recorded next to each digest, files that only hold a SHA-1 digest are still read.
+void io1::TestAccount::TestHashAlgorithm(void) const
+{
+  for (auto const filename : { "test_hash.act", "test_hash.lst", "test_hash_0.lst" }) boost::filesystem::remove(filename);
+
+  auto const read_file = [](char const * filename)
+  {
+    boost::filesystem::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+  };
+  auto const write_file = [](char const * filename, std::string const & content) { boost::filesystem::ofstream(filename, std::ios::binary) << content; };
+
+  {
+    Account a{ 100_USD, QDate{ 2020,1,1 } };
+    a.set_name("test_hash").set_hash_algorithm(HashAlgorithm::xxh64);
+    auto & listing = a.current_listing();
+    for (int i = 0; 10 > i; ++i) listing.set_committed(listing.add_statement(1_USD, "deposit", QDate{ 2020,2,1 }.addDays(i)));
+    a.archive("test_hash_0", 1024);
+    listing.add_statement(-7_USD, "pending withdrawal", QDate{ 2020,4,1 });
+    ASSERT_EQ(HashAlgorithm::xxh64, a.archived_listings().back().checksum().algorithm());
+
+    save_as("test_hash.act", a);
+  }
+
+  auto const content = read_file("test_hash.act");
+  ASSERT_NE(std::string::npos, content.find(checksum(HashAlgorithm::xxh64, read_file("test_hash.lst")).to_string() + "\ttest_hash.lst"));
+  ASSERT_NE(std::string::npos, content.find(checksum(HashAlgorithm::xxh64, read_file("test_hash_0.lst")).to_string()));
+
+  auto a = open("test_hash.act");
+  ASSERT_EQ(HashAlgorithm::xxh64, a.hash_algorithm());
+  ASSERT_EQ(11, a.archived_listing(0)->statements().size()); // the initial balance is archived too.
+
+  // a file written before algorithms were recorded.
+  auto legacy = content;
+  boost::algorithm::replace_all(legacy, checksum(HashAlgorithm::xxh64, read_file("test_hash.lst")).to_string(), checksum(HashAlgorithm::sha1, read_file("test_hash.lst")).digest());
+  boost::algorithm::replace_all(legacy, checksum(HashAlgorithm::xxh64, read_file("test_hash_0.lst")).to_string(), checksum(HashAlgorithm::sha1, read_file("test_hash_0.lst")).digest());
+  write_file("test_hash.act", legacy);
+
+  a = open("test_hash.act");
+  ASSERT_EQ(HashAlgorithm::sha1, a.hash_algorithm());
+  ASSERT_EQ(11, a.archived_listing(0)->statements().size()); // the initial balance is archived too.
+  ASSERT_EQ(103_USD, a.balance());
+
+  for (auto const filename : { "test_hash.act", "test_hash.lst", "test_hash_0.lst" }) boost::filesystem::remove(filename);
+  return;
+}
+
+void io1::TestAccount::TestBlockLayout(void) const
+{
+  for (auto const filename : { "test_blocks.lst", "test_blocks.blk" }) boost::filesystem::remove(filename);
+
+  Account a{ 100_USD, QDate{ 2020,1,1 } };
+  a.set_name("test_blocks").set_block_size(4);
+  auto & listing = a.current_listing();
+  for (int i = 0; 10 > i; ++i) listing.add_statement(1_USD, "deposit", QDate{ 2020,2,1 }.addDays(i));
+
+  std::stringstream stream;
+  stream << a;
+  ASSERT_NE(std::string::npos, stream.str().find("\ttest_blocks.lst\ttest_blocks.blk\n"));
+
+  auto read = Account::read(stream);
+  ASSERT_EQ(4, read.block_size());
+  ASSERT_EQ(a.current_listing(), read.current_listing());
+  ASSERT_EQ(110_USD, read.balance());
+
+  // the read listing keeps the checksums it was verified against, an edit then only changes its block.
+  auto const & checksums = read.current_listing().block_checksums(HashAlgorithm::sha1, 4);
+  ASSERT_EQ(3, checksums.blocks().size());
+  auto const first_checksum = checksums.blocks()[0].checksum;
+  read.current_listing().alter_statement(read.current_listing().begin() + 5, 2_USD, "deposit", QDate{ 2020,2,5 });
+  std::stringstream edited;
+  edited << read;
+  ASSERT_EQ(first_checksum, read.current_listing().block_checksums(HashAlgorithm::sha1, 4).blocks()[0].checksum);
+  ASSERT_EQ(111_USD, Account::read(edited).balance());
+
+  // committing a statement goes through the listing, which rehashes its block before the next save.
+  read.current_listing().set_committed(read.current_listing().begin() + 6);
+  edited.str("");
+  edited.clear();
+  edited << read;
+  ASSERT_TRUE(Account::read(edited).current_listing().begin()[6].is_committed());
+
+  // a corrupted listing file is reported with its block.
+  {
+    boost::filesystem::fstream file("test_blocks.lst", std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(checksums.blocks()[0].byte_count + checksums.blocks()[1].byte_count + 2));
+    file.put('#');
+  }
+  edited.clear();
+  edited.seekg(0);
+  try
+  {
+    Account::read(edited);
+    FAIL() << "corruption not detected";
+  }
+  catch (Sha1Mismatch const & e)
+  {
+    ASSERT_EQ(2, *boost::get_error_info<BlockChecksums::errinfo_block_index>(e));
+  }
+
+  for (auto const filename : { "test_blocks.lst", "test_blocks.blk" }) boost::filesystem::remove(filename);
+  return;
+}
@@ -0,0 +1,103 @@
+/// \file test_archive_cache.cpp
+#include "gtest/gtest.h"
+#include "archive_cache.hpp"
+#include "archive_writer.hpp"
+#include <boost/filesystem/operations.hpp>
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace io1 {
+
+  class TestArchiveCache : public ::testing::Test
+  {
+  public:
+    void TestEviction(void) const;
+    void TestConcurrentLoad(void) const;
+
+  private:
+    static ArchivedListing WriteArchive(std::string const & name, int count); // writes an archive whose listing is not loaded.
+  };
+
+  TEST_F(TestArchiveCache, TestEviction) { return TestEviction(); };
+  TEST_F(TestArchiveCache, TestConcurrentLoad) { return TestConcurrentLoad(); };
+}
+
+io1::ArchivedListing io1::TestArchiveCache::WriteArchive(std::string const & name, int count)
+{
+  boost::filesystem::remove(name + ".lst");
+
+  ArchiveWriter writer(name + ".lst", QString::fromStdString(name), 0_USD);
+  for (int i = 0; count > i; ++i) writer.add(Statement(Money{ i }, QString::fromStdString("statement " + std::to_string(i)), QDate{ 2020,1,1 }.addDays(i)));
+
+  return writer.finish();
+}
+
+void io1::TestArchiveCache::TestEviction(void) const
+{
+  std::array const archives{ WriteArchive("test_cache_0", 100), WriteArchive("test_cache_1", 100), WriteArchive("test_cache_2", 100) };
+
+  ArchiveCache cache;
+  auto const first = cache.listing(archives[0]);
+  ASSERT_EQ(100, first->statements().size());
+  ASSERT_TRUE(archives[0].is_loaded());
+  ASSERT_EQ(first->memory_usage(), cache.memory_usage());
+
+  // the budget holds two listings, the least recently used one is evicted by the third.
+  cache.set_memory_budget(2 * cache.memory_usage());
+  ASSERT_EQ(first, cache.listing(archives[0]));
+  cache.listing(archives[1]);
+  ASSERT_EQ(first, cache.listing(archives[0])); // archives[1] is now the least recently used.
+  cache.listing(archives[2]);
+
+  ASSERT_EQ(2, cache.size());
+  ASSERT_TRUE(archives[0].is_loaded());
+  ASSERT_FALSE(archives[1].is_loaded());
+  ASSERT_TRUE(archives[2].is_loaded());
+  ASSERT_EQ(2, cache.statistics().hits);
+  ASSERT_EQ(3, cache.statistics().misses);
+  ASSERT_EQ(1, cache.statistics().evictions);
+
+  // the most recent listing is kept even when it does not fit.
+  cache.set_memory_budget(0);
+  ASSERT_EQ(1, cache.size());
+  ASSERT_TRUE(archives[2].is_loaded());
+  ASSERT_EQ(2, cache.statistics().evictions);
+
+  // an evicted listing stays valid for its readers and is loaded again on the next miss.
+  ASSERT_EQ(100, first->statements().size());
+  ASSERT_NE(first, cache.listing(archives[0]));
+  ASSERT_EQ(*first, *cache.listing(archives[0]));
+  ASSERT_EQ(4, cache.statistics().misses);
+
+  cache.clear();
+  ASSERT_EQ(0, cache.size());
+  ASSERT_EQ(0, cache.memory_usage());
+  ASSERT_FALSE(archives[0].is_loaded());
+
+  for (auto const & archive : archives) boost::filesystem::remove(archive.filename());
+  return;
+}
+
+// Readers racing on an archive that is not loaded must all get the one listing, read once from the file.
+void io1::TestArchiveCache::TestConcurrentLoad(void) const
+{
+  auto const archive = WriteArchive("test_cache_concurrent", 1000);
+  ArchiveCache cache;
+
+  std::vector<ArchivedListing::shared_listing_type> listings(8);
+  {
+    std::vector<std::jthread> readers;
+    for (auto & listing : listings) readers.emplace_back([&] { listing = cache.listing(archive); });
+  }
+
+  for (auto const & listing : listings) ASSERT_EQ(listings.front(), listing);
+  ASSERT_EQ(1000, listings.front()->statements().size());
+  ASSERT_EQ(1, cache.size());
+  ASSERT_EQ(1, cache.statistics().misses);
+  ASSERT_EQ(listings.size() - 1, cache.statistics().hits);
+
+  boost::filesystem::remove(archive.filename());
+  return;
+}
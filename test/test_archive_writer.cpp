@@ -0,0 +1,85 @@
+/// \file test_archive_writer.cpp
+#include "gtest/gtest.h"
+#include "archive_writer.hpp"
+#include "archive_cache.hpp"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <iterator>
+#include <string>
+
+namespace io1 {
+
+  class TestArchiveWriter : public ::testing::Test
+  {
+  public:
+    void TestInMemory(void) const;
+    void TestExternalSort(void) const;
+    void TestColumnar(void) const;
+
+  private:
+    static void TestArchive(std::size_t memory_budget, bool spills, ArchivedListing::format_type format = ArchivedListing::format_type::text);
+  };
+
+  TEST_F(TestArchiveWriter, TestInMemory) { return TestInMemory(); };
+  TEST_F(TestArchiveWriter, TestExternalSort) { return TestExternalSort(); };
+  TEST_F(TestArchiveWriter, TestColumnar) { return TestColumnar(); };
+}
+
+void io1::TestArchiveWriter::TestInMemory(void) const
+{
+  return TestArchive(ArchiveWriter::default_memory_budget, false);
+}
+
+void io1::TestArchiveWriter::TestExternalSort(void) const
+{
+  TestArchive(512, true);
+  TestArchive(1, true); // a run per statement, too many to be merged in a single pass.
+  return;
+}
+
+void io1::TestArchiveWriter::TestColumnar(void) const
+{
+  TestArchive(ArchiveWriter::default_memory_budget, false, ArchivedListing::format_type::columnar);
+  TestArchive(512, true, ArchivedListing::format_type::columnar);
+  TestArchive(512, true, ArchivedListing::format_type::compressed);
+  return;
+}
+
+// The streamed archive must be the very file that an archive written from a listing would be.
+void io1::TestArchiveWriter::TestArchive(std::size_t memory_budget, bool spills, ArchivedListing::format_type format)
+{
+  boost::filesystem::remove("test_streamed.lst");
+  boost::filesystem::remove("test_expected.lst");
+
+  // statements of the same date are added out of order, and must keep their relative order.
+  ArchivedListing::listing_type listing{ "archive" };
+  for (int i = 0; 200 > i; ++i) listing.add_statement(Money{ i }, QString::fromStdString("statement " + std::to_string(i)), QDate{ 2020,1,1 }.addDays((i * 37) % 50));
+
+  ArchivedListing streamed;
+  {
+    ArchiveWriter writer("test_streamed.lst", "archive", 100_USD, memory_budget, HashAlgorithm::sha1, format);
+    for (auto const & statement : listing.statements()) writer.add(statement);
+    streamed = writer.finish();
+    ASSERT_EQ(spills, 1 < writer.run_count());
+  }
+  ASSERT_FALSE(boost::filesystem::exists("test_streamed.lst.run0")); // runs are removed.
+
+  ArchivedListing const expected("test_expected.lst", listing, QDate{ 2020,1,1 }.addDays(49), 100_USD + listing.total_amount(), HashAlgorithm::sha1, format);
+  ASSERT_EQ(expected.final_balance(), streamed.final_balance());
+
+  auto const read_file = [](char const * filename)
+  {
+    boost::filesystem::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+  };
+  ASSERT_EQ(read_file("test_expected.lst"), read_file("test_streamed.lst"));
+
+  // the listing is loaded from the file on demand.
+  ArchiveCache cache;
+  ASSERT_EQ(*cache.listing(expected), *cache.listing(streamed));
+  ASSERT_TRUE(cache.listing(streamed)->is_sorted());
+
+  boost::filesystem::remove("test_streamed.lst");
+  boost::filesystem::remove("test_expected.lst");
+  return;
+}
@@ -0,0 +1,159 @@
+/// \file test_block_checksums.cpp
+#include "gtest/gtest.h"
+#include "listing.hpp"
+#include "block_checksums.hpp"
+#include "accounting_exception.hpp"
+#include <boost/exception/get_error_info.hpp>
+#include <sstream>
+#include <string>
+
+namespace io1 {
+
+  class TestBlockChecksums : public ::testing::Test
+  {
+  public:
+    void TestIncremental(void) const;
+    void TestVerify(void) const;
+    void TestReadWrite(void) const;
+
+  private:
+    using listing_type = Listing<committable_tag>;
+    static listing_type MakeListing(int count);
+    static std::string Format(listing_type const & listing);
+    static BlockChecksums Recompute(listing_type const & listing, std::size_t block_size); // checksums of a fresh copy, which has no cached block.
+  };
+
+  TEST_F(TestBlockChecksums, TestIncremental) { return TestIncremental(); };
+  TEST_F(TestBlockChecksums, TestVerify) { return TestVerify(); };
+  TEST_F(TestBlockChecksums, TestReadWrite) { return TestReadWrite(); };
+}
+
+io1::TestBlockChecksums::listing_type io1::TestBlockChecksums::MakeListing(int count)
+{
+  listing_type listing("blocks");
+  for (int i = 0; count > i; ++i) listing.add_statement(Money{ 100 * i }, QString("statement"), QDate{ 2020,1,1 }.addDays(i));
+  return listing;
+}
+
+std::string io1::TestBlockChecksums::Format(listing_type const & listing)
+{
+  std::string buffer;
+  listing.format_to(std::back_inserter(buffer));
+  return buffer;
+}
+
+io1::BlockChecksums io1::TestBlockChecksums::Recompute(listing_type const & listing, std::size_t block_size)
+{
+  return listing_type::read(Format(listing)).block_checksums(HashAlgorithm::sha1, block_size);
+}
+
+// Each edit leaves the checksums as if they were computed from scratch, and only rehashes the blocks it changed.
+void io1::TestBlockChecksums::TestIncremental(void) const
+{
+  std::size_t const block_size = 4;
+  auto listing = MakeListing(10);
+
+  auto checksums = listing.block_checksums(HashAlgorithm::sha1, block_size);
+  ASSERT_EQ(3, checksums.blocks().size());
+  ASSERT_EQ(2, checksums.blocks().back().statement_count);
+  ASSERT_EQ(Format(listing).size(), checksums.blocks()[0].byte_count + checksums.blocks()[1].byte_count + checksums.blocks()[2].byte_count);
+  ASSERT_EQ(Recompute(listing, block_size), checksums);
+  ASSERT_TRUE(checksums.is_up_to_date(10));
+  ASSERT_FALSE(checksums.is_up_to_date(11));
+
+  auto const changed_blocks = [&]
+  {
+    auto const & updated = listing.block_checksums(HashAlgorithm::sha1, block_size);
+    EXPECT_EQ(Recompute(listing, block_size), updated);
+
+    std::vector<std::size_t> changed;
+    for (std::size_t block = 0; updated.blocks().size() > block; ++block)
+      if (checksums.blocks().size() <= block || checksums.blocks()[block].checksum != updated.blocks()[block].checksum) changed.push_back(block);
+    checksums = updated;
+    return changed;
+  };
+
+  listing.alter_statement(listing.begin() + 5, 7_USD, "altered", QDate{ 2020,1,6 });
+  ASSERT_EQ(std::vector<std::size_t>{ 1 }, changed_blocks());
+
+  listing.set_committed(listing.begin() + 9);
+  ASSERT_EQ(std::vector<std::size_t>{ 2 }, changed_blocks());
+
+  listing.add_statement(1_USD, "appended", QDate{ 2020,2,1 });
+  ASSERT_EQ(std::vector<std::size_t>{ 2 }, changed_blocks());
+
+  listing.set_name("renamed");
+  ASSERT_EQ(std::vector<std::size_t>{ 0 }, changed_blocks());
+
+  listing.swap_statements(listing.begin() + 1, listing.begin() + 10);
+  ASSERT_EQ((std::vector<std::size_t>{ 0, 2 }), changed_blocks());
+
+  listing.erase_statement(listing.begin() + 6);
+  ASSERT_EQ((std::vector<std::size_t>{ 1, 2 }), changed_blocks());
+
+  listing.set_journal_limit(1 << 20);
+  listing.alter_statement(listing.begin(), 3_USD, "altered", QDate{ 2020,1,1 });
+  changed_blocks();
+  listing.undo();
+  ASSERT_EQ(std::vector<std::size_t>{ 0 }, changed_blocks());
+
+  // the cache follows changes of algorithm and of block size.
+  ASSERT_EQ(HashAlgorithm::xxh64, listing.block_checksums(HashAlgorithm::xxh64, block_size).algorithm());
+  ASSERT_EQ(1, listing.block_checksums(HashAlgorithm::sha1).blocks().size());
+
+  // an empty listing has a block, for its title.
+  ASSERT_EQ(1, listing_type("empty").block_checksums(HashAlgorithm::sha1).blocks().size());
+
+  return;
+}
+
+void io1::TestBlockChecksums::TestVerify(void) const
+{
+  auto const listing = MakeListing(10);
+  auto const & checksums = listing.block_checksums(HashAlgorithm::xxh64, 4);
+  auto const bytes = Format(listing);
+  ASSERT_NO_THROW(checksums.verify(bytes));
+
+  auto const failed_block = [&](std::string const & corrupted) -> std::size_t
+  {
+    try
+    {
+      checksums.verify(corrupted);
+    }
+    catch (Sha1Mismatch const & e)
+    {
+      return *boost::get_error_info<BlockChecksums::errinfo_block_index>(e);
+    }
+    ADD_FAILURE() << "corruption not detected";
+    return 0;
+  };
+
+  auto corrupted = bytes;
+  corrupted[checksums.blocks()[0].byte_count + 3] ^= 1;
+  ASSERT_EQ(1, failed_block(corrupted));
+
+  ASSERT_EQ(2, failed_block(bytes + "\n"));
+  ASSERT_EQ(1, failed_block(bytes.substr(0, checksums.blocks()[0].byte_count + 1)));
+  ASSERT_EQ(2, failed_block(bytes.substr(0, checksums.blocks()[0].byte_count + checksums.blocks()[1].byte_count)));
+
+  return;
+}
+
+void io1::TestBlockChecksums::TestReadWrite(void) const
+{
+  auto const listing = MakeListing(10);
+  auto const & checksums = listing.block_checksums(HashAlgorithm::xxh64, 3);
+
+  std::stringstream stream;
+  stream << checksums;
+  ASSERT_EQ(checksum(HashAlgorithm::xxh64, stream.str()), checksums.root());
+
+  BlockChecksums read;
+  ASSERT_TRUE(stream >> read);
+  ASSERT_EQ(checksums, read);
+
+  std::istringstream corrupted("xxh64 3 2\n3 10 sha1:a9993e364706816aba3e25717850c26c9cd0d89d\n");
+  ASSERT_THROW(corrupted >> read, ParseError);
+
+  return;
+}
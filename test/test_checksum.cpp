@@ -0,0 +1,135 @@
+/// \file test_checksum.cpp
+#include "gtest/gtest.h"
+#include "checksum.hpp"
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <sstream>
+#include <string>
+
+namespace io1 {
+
+  class TestChecksum : public ::testing::Test
+  {
+  public:
+    void TestSha1(void) const;
+    void TestXxh64(void) const;
+    void TestIncremental(void) const;
+    void TestReadWrite(void) const;
+    void TestFilter(void) const;
+
+  private:
+    static std::string Bytes(std::size_t size); // size bytes of a varied content.
+  };
+
+  TEST_F(TestChecksum, TestSha1) { return TestSha1(); };
+  TEST_F(TestChecksum, TestXxh64) { return TestXxh64(); };
+  TEST_F(TestChecksum, TestIncremental) { return TestIncremental(); };
+  TEST_F(TestChecksum, TestReadWrite) { return TestReadWrite(); };
+  TEST_F(TestChecksum, TestFilter) { return TestFilter(); };
+}
+
+std::string io1::TestChecksum::Bytes(std::size_t size)
+{
+  std::string bytes(size, '\0');
+  for (std::size_t i = 0; size > i; ++i) bytes[i] = static_cast<char>(i % 256);
+  return bytes;
+}
+
+// The FIPS 180 examples, with and without the SHA instructions.
+void io1::TestChecksum::TestSha1(void) const
+{
+  auto const accelerated = sha1_acceleration();
+  for (bool const enabled : { false, true })
+  {
+    set_sha1_acceleration(enabled);
+    ASSERT_EQ(enabled && accelerated, sha1_acceleration());
+
+    ASSERT_EQ("da39a3ee5e6b4b0d3255bfef95601890afd80709", checksum(HashAlgorithm::sha1, std::string_view()).digest());
+    ASSERT_EQ("a9993e364706816aba3e25717850c26c9cd0d89d", checksum(HashAlgorithm::sha1, "abc").digest());
+    ASSERT_EQ("84983e441c3bd26ebaae4aa1f95129e5e54670f1", checksum(HashAlgorithm::sha1, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").digest());
+    ASSERT_EQ("34aa973cd4c4daa4f61eeb2bdbad27316534016f", checksum(HashAlgorithm::sha1, std::string(1'000'000, 'a')).digest());
+  }
+  set_sha1_acceleration(true);
+
+  return;
+}
+
+// Reference values of XXH64 with a null seed.
+void io1::TestChecksum::TestXxh64(void) const
+{
+  ASSERT_EQ("ef46db3751d8e999", checksum(HashAlgorithm::xxh64, std::string_view()).digest());
+  ASSERT_EQ("d24ec4f1a98c6e5b", checksum(HashAlgorithm::xxh64, "a").digest());
+  ASSERT_EQ("44bc2cf5ad770999", checksum(HashAlgorithm::xxh64, "abc").digest());
+  ASSERT_EQ("a76190c3acf08a1c", checksum(HashAlgorithm::xxh64, "0123456789abcdef0123456789abcdef0123456789").digest());
+  ASSERT_EQ("8e03c838c596036f", checksum(HashAlgorithm::xxh64, Bytes(768)).digest());
+
+  return;
+}
+
+// Bytes may be hashed in pieces of any size, and the checksum read at any time.
+void io1::TestChecksum::TestIncremental(void) const
+{
+  auto const bytes = Bytes(1000);
+  for (auto const algorithm : { HashAlgorithm::sha1, HashAlgorithm::xxh64 })
+  {
+    auto const expected = checksum(algorithm, bytes);
+    for (std::size_t piece : { 1, 7, 31, 32, 63, 64, 65, 500 })
+    {
+      Hasher hasher(algorithm);
+      for (std::size_t offset = 0; bytes.size() > offset; offset += piece)
+      {
+        hasher.update(std::string_view(bytes).substr(offset, piece));
+        ASSERT_EQ(checksum(algorithm, std::string_view(bytes).substr(0, std::min(bytes.size(), offset + piece))), hasher.checksum());
+      }
+      ASSERT_EQ(expected, hasher.checksum());
+    }
+  }
+
+  return;
+}
+
+void io1::TestChecksum::TestReadWrite(void) const
+{
+  auto const sha1 = checksum(HashAlgorithm::sha1, "abc");
+  auto const xxh64 = checksum(HashAlgorithm::xxh64, "abc");
+  ASSERT_EQ("sha1:a9993e364706816aba3e25717850c26c9cd0d89d", sha1.to_string());
+  ASSERT_EQ("xxh64:44bc2cf5ad770999", xxh64.to_string());
+
+  std::stringstream stream;
+  stream << sha1 << ' ' << xxh64 << ' ' << sha1.digest(); // the last one as written before algorithms were recorded.
+
+  Checksum read;
+  ASSERT_TRUE(stream >> read);
+  ASSERT_EQ(sha1, read);
+  ASSERT_TRUE(stream >> read);
+  ASSERT_EQ(xxh64, read);
+  ASSERT_TRUE(stream >> read);
+  ASSERT_EQ(sha1, read);
+
+  ASSERT_FALSE(Checksum::parse("md5:900150983cd24fb0d6963f7d28e17f72", read));
+  ASSERT_FALSE(Checksum::parse("xxh64:a9993e364706816aba3e25717850c26c9cd0d89d", read));
+  ASSERT_FALSE(Checksum::parse("a9993e364706816aba3e25717850c26c9cd0d89", read));
+  ASSERT_FALSE(Checksum::parse("A9993E364706816ABA3E25717850C26C9CD0D89D", read));
+
+  return;
+}
+
+void io1::TestChecksum::TestFilter(void) const
+{
+  auto const bytes = Bytes(10'000);
+  for (auto const algorithm : { HashAlgorithm::sha1, HashAlgorithm::xxh64 })
+  {
+    std::string copy;
+    ChecksumFilter const filter(algorithm);
+    {
+      boost::iostreams::filtering_ostream out;
+      out.push(filter);
+      out.push(boost::iostreams::back_inserter(copy));
+      out << bytes << std::flush;
+    }
+    ASSERT_EQ(bytes, copy);
+    ASSERT_EQ(checksum(algorithm, bytes), filter.checksum());
+  }
+
+  return;
+}
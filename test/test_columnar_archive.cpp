@@ -0,0 +1,209 @@
+/// \file test_columnar_archive.cpp
+#include "gtest/gtest.h"
+#include "columnar_archive.hpp"
+#include "archive_cache.hpp"
+#include "archived_listing.hpp"
+#include "block_checksums.hpp"
+#include "accounting_exception.hpp"
+#include <boost/exception/get_error_info.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace io1 {
+
+  class TestColumnarArchive : public ::testing::Test
+  {
+  public:
+    void TestRoundTrip(void) const;
+    void TestDateRange(void) const;
+    void TestCorruption(void) const;
+    void TestArchivedListing(void) const;
+    void TestCompressed(void) const;
+
+  private:
+    using listing_type = ColumnarArchive::listing_type;
+    using encoding_type = ColumnarArchive::encoding_type;
+    static listing_type MakeListing(int count); // one statement a day from 2020-01-01, every fifth one composed.
+    static std::string Write(listing_type const & listing, std::size_t block_size, encoding_type encoding = encoding_type::fixed);
+  };
+
+  TEST_F(TestColumnarArchive, TestRoundTrip) { return TestRoundTrip(); };
+  TEST_F(TestColumnarArchive, TestDateRange) { return TestDateRange(); };
+  TEST_F(TestColumnarArchive, TestCorruption) { return TestCorruption(); };
+  TEST_F(TestColumnarArchive, TestArchivedListing) { return TestArchivedListing(); };
+  TEST_F(TestColumnarArchive, TestCompressed) { return TestCompressed(); };
+}
+
+io1::TestColumnarArchive::listing_type io1::TestColumnarArchive::MakeListing(int count)
+{
+  listing_type listing("columnar");
+  for (int i = 0; count > i; ++i)
+  {
+    auto const date = QDate{ 2020,1,1 }.addDays(i);
+    if (0 == i % 5)
+    {
+      std::vector<Entry> entries;
+      entries.emplace_back(Money{ 100 * i }, "cheque " + std::to_string(i), date);
+      entries.emplace_back(Money{ -250 }, "", date);
+      listing.add_statement(QString("deposit"), date, entries);
+    }
+    else listing.add_statement(Money{ 100 * i - 50'000 }, QString::fromStdString("statement " + std::to_string(i)), date);
+  }
+  return listing;
+}
+
+std::string io1::TestColumnarArchive::Write(listing_type const & listing, std::size_t block_size, encoding_type encoding)
+{
+  std::ostringstream stream;
+  ColumnarArchiveWriter writer(stream, listing.name().toStdString(), HashAlgorithm::xxh64, block_size, encoding);
+  for (auto const & statement : listing.statements()) writer.add(statement);
+  writer.finish();
+  return stream.str();
+}
+
+void io1::TestColumnarArchive::TestRoundTrip(void) const
+{
+  for (int const count : { 0, 1, 8, 30 })
+  {
+    auto const listing = MakeListing(count);
+    auto const bytes = Write(listing, 8);
+    ASSERT_TRUE(ColumnarArchive::is_columnar(bytes));
+
+    ColumnarArchive const archive(bytes);
+    ASSERT_EQ("columnar", archive.name());
+    ASSERT_EQ(static_cast<std::size_t>(count), archive.size());
+    ASSERT_EQ(static_cast<std::size_t>((count + 7) / 8), archive.blocks().size());
+
+    auto const read = archive.listing();
+    ASSERT_EQ(listing, read);
+    ASSERT_EQ(listing.total_amount(), read.total_amount());
+  }
+
+  std::ostringstream text;
+  text << MakeListing(3);
+  ASSERT_FALSE(ColumnarArchive::is_columnar(text.str()));
+
+  return;
+}
+
+// Blocks that do not overlap the range are neither read nor checked.
+void io1::TestColumnarArchive::TestDateRange(void) const
+{
+  auto const listing = MakeListing(30);
+  auto bytes = Write(listing, 8);
+
+  std::chrono::year_month_day const from = 2020y / 1 / 10;
+  std::chrono::year_month_day const to = 2020y / 1 / 12;
+  auto const expected = std::vector<Statement>(listing.begin() + 9, listing.begin() + 12);
+  ASSERT_EQ(expected, ColumnarArchive(bytes).statements_between(from, to));
+  ASSERT_TRUE(ColumnarArchive(bytes).statements_between(2021y / 1 / 1, 2021y / 2 / 1).empty());
+
+  auto const blocks = ColumnarArchive(bytes).blocks();
+  ASSERT_EQ(8, blocks[1].first_day - blocks[0].first_day);
+  bytes[blocks[3].offset] ^= 1;
+  ASSERT_EQ(expected, ColumnarArchive(bytes).statements_between(from, to));
+
+  bytes[blocks[1].offset + 3] ^= 1;
+  try
+  {
+    ColumnarArchive(bytes).statements_between(from, to);
+    FAIL() << "corruption not detected";
+  }
+  catch (Sha1Mismatch const & e)
+  {
+    ASSERT_EQ(1, *boost::get_error_info<BlockChecksums::errinfo_block_index>(e));
+  }
+
+  return;
+}
+
+void io1::TestColumnarArchive::TestCorruption(void) const
+{
+  auto const bytes = Write(MakeListing(30), 8);
+
+  for (std::size_t position : { bytes.size() - 1, bytes.size() - 12, bytes.size() - 40, bytes.size() - 100 })
+  {
+    auto corrupted = bytes;
+    corrupted[position] ^= 1;
+    ASSERT_THROW(ColumnarArchive{ corrupted }, CorruptedFile);
+  }
+  ASSERT_THROW(ColumnarArchive{ bytes.substr(0, bytes.size() - 1) }, CorruptedFile);
+  ASSERT_THROW(ColumnarArchive{ bytes.substr(0, 12) }, CorruptedFile);
+
+  return;
+}
+
+// A columnar archive holds the same listing and answers date ranges like a text one.
+void io1::TestColumnarArchive::TestArchivedListing(void) const
+{
+  for (auto const filename : { "test_columnar.lst", "test_text.lst" }) boost::filesystem::remove(filename);
+
+  auto const listing = MakeListing(5000);
+  auto const final_date = QDate{ 2020,1,1 }.addDays(4999);
+  ArchivedListing const columnar("test_columnar.lst", listing, final_date, listing.total_amount(), HashAlgorithm::sha1, ArchivedListing::format_type::columnar);
+  ArchivedListing const text("test_text.lst", listing, final_date, listing.total_amount());
+  ASSERT_LT(boost::filesystem::file_size("test_columnar.lst"), boost::filesystem::file_size("test_text.lst"));
+
+  auto const reopened = ArchivedListing(columnar.filename(), final_date, columnar.final_balance(), columnar.checksum());
+  std::chrono::year_month_day const from = 2022y / 3 / 1;
+  std::chrono::year_month_day const to = 2022y / 3 / 31;
+  auto const statements = reopened.statements_between(from, to);
+  ASSERT_EQ(31, statements.size());
+  ASSERT_FALSE(reopened.is_loaded()); // only the blocks of march were read.
+  ASSERT_EQ(text.statements_between(from, to), statements);
+
+  ArchiveCache cache;
+  ASSERT_EQ(*cache.listing(text), *cache.listing(reopened));
+  ASSERT_EQ(statements, reopened.statements_between(from, to)); // now answered from memory.
+
+  for (auto const filename : { "test_columnar.lst", "test_text.lst" }) boost::filesystem::remove(filename);
+  return;
+}
+
+// Compressed blocks hold the same statements as fixed ones, whatever the amounts and dates.
+void io1::TestColumnarArchive::TestCompressed(void) const
+{
+  for (int const count : { 0, 1, 8, 30 })
+  {
+    auto const listing = MakeListing(count);
+    auto const bytes = Write(listing, 8, encoding_type::compressed);
+    ASSERT_TRUE(ColumnarArchive::is_columnar(bytes));
+
+    ColumnarArchive const archive(bytes);
+    ASSERT_EQ(encoding_type::compressed, archive.encoding());
+    ASSERT_EQ(listing, archive.listing());
+    ASSERT_EQ(encoding_type::fixed, ColumnarArchive(Write(listing, 8)).encoding());
+  }
+
+  // repeated descriptions are stored once per block, and small numbers take a byte or two.
+  auto const listing = MakeListing(1000);
+  auto const bytes = Write(listing, ColumnarArchiveWriter::default_block_size, encoding_type::compressed);
+  ASSERT_LT(bytes.size(), Write(listing, ColumnarArchiveWriter::default_block_size).size());
+  ASSERT_EQ(listing, ColumnarArchive(bytes).listing());
+
+  listing_type extremes("extremes");
+  extremes.add_statement(Money{ std::numeric_limits<std::int64_t>::max() }, QString("max"), QDate{ 1900,1,1 });
+  extremes.add_statement(Money{ std::numeric_limits<std::int64_t>::min() }, QString("min"), QDate{ 2100,12,31 });
+  extremes.add_statement(Money{ 0 }, QString(""), QDate{ 1970,1,1 });
+  ASSERT_EQ(extremes, ColumnarArchive(Write(extremes, 2, encoding_type::compressed)).listing());
+
+  auto corrupted = Write(MakeListing(30), 8, encoding_type::compressed);
+  auto const blocks = ColumnarArchive(corrupted).blocks();
+  corrupted[blocks[2].offset + blocks[2].size - 1] ^= 1;
+  std::vector<Statement> statements;
+  ASSERT_THROW(ColumnarArchive(corrupted).read_block(2, statements), Sha1Mismatch);
+
+  // a block cut short is reported, not read past its end.
+  corrupted = Write(MakeListing(30), 8, encoding_type::compressed);
+  corrupted[blocks[0].offset + blocks[0].size - 1] = '\x80';
+  ASSERT_THROW(ColumnarArchive(corrupted).listing(), CorruptedFile);
+
+  return;
+}
@@ -13,10 +13,12 @@ namespace io1 {
   public:
     void TestFailedConstruction(void) const;
     void TestReadWrite(void) const;
+    void TestReadBuffer(void) const;
   };
 
   TEST_F(TestEntry, TestFailedConstruction) { return TestFailedConstruction(); };
   TEST_F(TestEntry, TestReadWrite) { return TestReadWrite(); };
+  TEST_F(TestEntry, TestReadBuffer) { return TestReadBuffer(); };
 }
 
 void io1::TestEntry::TestFailedConstruction(void) const
@@ -70,3 +72,39 @@ void io1::TestEntry::TestReadWrite(void) const
 
   return;
 }
+
+void io1::TestEntry::TestReadBuffer(void) const
+{
+  using namespace std::chrono;
+
+  Entry e1{-12.34_USD, "A long description with whitespaces to check just about everything", 2018y/July/28d};
+  Entry e2{1234567.89_USD, "Another description", 2019y/July/28d};
+  Entry e3{0_USD, "", 2020y/February/29d};
+
+  std::stringstream stream;
+  stream << e1 << e2 << e3;
+  auto const buffer = stream.str();
+  std::string_view view = buffer;
+
+  Entry e1_read, e2_read, e3_read;
+  view.remove_prefix(Entry::read(view, e1_read));
+  view.remove_prefix(Entry::read(view, e2_read));
+  view.remove_prefix(Entry::read(view, e3_read));
+
+  ASSERT_TRUE(view.empty());
+  ASSERT_EQ(e1, e1_read);
+  ASSERT_EQ(e2, e2_read);
+  ASSERT_EQ(e3, e3_read);
+
+  // the last line may lack its end of line and use CRLF line endings.
+  Entry e4_read;
+  ASSERT_EQ(33, Entry::read("  2021-07-28-1250     A line.  \r\n", e4_read));
+  ASSERT_EQ(Entry(-12.5_USD, "A line.", 2021y/July/28d), e4_read);
+  ASSERT_EQ(29, Entry::read("2021-07-28-1250     A line.  ", e4_read));
+
+  ASSERT_THROW(Entry::read("2021-02-30-1250     Invalid date.\n", e4_read), InvalidDateFormat);
+  ASSERT_THROW(Entry::read("2021/07/28-1250     Invalid date format.\n", e4_read), InvalidDateFormat);
+  ASSERT_THROW(Entry::read("2021-07-28$12.50    Invalid amount.\n", e4_read), ParseError);
+
+  return;
+}
@@ -1,6 +1,8 @@
 /// \file test_listing.cpp
 #include "gtest/gtest.h"
 #include "listing.hpp"
+#include "accounting_exception.hpp"
+#include <boost/exception/get_error_info.hpp>
 
 namespace io1 {
 
@@ -13,7 +15,17 @@ namespace io1 {
     template <typename committed_tag> void TestSplit(void) const;
     template <typename committed_tag> void TestMoveStatement(void) const;
     template <typename committed_tag> void TestReadWrite(void) const;
+    template <typename committed_tag> void TestColumns(void) const;
+    template <typename committed_tag> void TestTotalAmount(void) const;
+    template <typename committed_tag> void TestStatementsBetween(void) const;
+    template <typename committed_tag> void TestIncrementalSort(void) const;
+    template <typename committed_tag> void TestHandles(void) const;
+    template <typename committed_tag> void TestSelectionBitmap(void) const;
+    template <typename committed_tag> void TestTransaction(void) const;
+    template <typename committed_tag> void TestJournal(void) const;
     void TestCommittable(void) const;
+    void TestCommitStates(void) const;
+    void TestExtractCommitted(void) const;
 	};
 	
   TEST_F(TestListing, TestInteraction) { return TestInteraction<non_committable_tag>(); };
@@ -29,6 +41,24 @@ namespace io1 {
   TEST_F(TestListing, TestCommittableMoveStatement) { return TestMoveStatement<committable_tag>(); };
   TEST_F(TestListing, TestCommittableReadWrite) { return TestReadWrite<committable_tag>(); };
   TEST_F(TestListing, TestCommittable) { return TestCommittable(); };
+  TEST_F(TestListing, TestCommitStates) { return TestCommitStates(); };
+  TEST_F(TestListing, TestExtractCommitted) { return TestExtractCommitted(); };
+  TEST_F(TestListing, TestColumns) { return TestColumns<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableColumns) { return TestColumns<committable_tag>(); };
+  TEST_F(TestListing, TestTotalAmount) { return TestTotalAmount<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableTotalAmount) { return TestTotalAmount<committable_tag>(); };
+  TEST_F(TestListing, TestStatementsBetween) { return TestStatementsBetween<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableStatementsBetween) { return TestStatementsBetween<committable_tag>(); };
+  TEST_F(TestListing, TestIncrementalSort) { return TestIncrementalSort<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableIncrementalSort) { return TestIncrementalSort<committable_tag>(); };
+  TEST_F(TestListing, TestHandles) { return TestHandles<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableHandles) { return TestHandles<committable_tag>(); };
+  TEST_F(TestListing, TestSelectionBitmap) { return TestSelectionBitmap<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableSelectionBitmap) { return TestSelectionBitmap<committable_tag>(); };
+  TEST_F(TestListing, TestTransaction) { return TestTransaction<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableTransaction) { return TestTransaction<committable_tag>(); };
+  TEST_F(TestListing, TestJournal) { return TestJournal<non_committable_tag>(); };
+  TEST_F(TestListing, TestCommittableJournal) { return TestJournal<committable_tag>(); };
 }
 
 void io1::TestListing::TestCommittable(void) const
@@ -56,6 +86,36 @@ template <typename COMMITTED_TAG> void io1::TestListing::TestReadWrite(void) con
   s >> l_read;
 
   ASSERT_EQ(l,l_read);
+
+  // a listing without statements, as left once everything is archived.
+  std::stringstream empty;
+  empty << Listing<COMMITTED_TAG>{ "Empty listing" };
+  empty >> l_read;
+  ASSERT_EQ(Listing<COMMITTED_TAG>{ "Empty listing" }, l_read);
+
+  // the same text is parsed from a buffer, composed and committed statements included.
+  std::vector<Entry> entries;
+  entries.emplace_back(10_USD, "first deposit.");
+  entries.emplace_back(20_USD, "second deposit.");
+  l.add_statement("deposits", QDate::currentDate(), entries);
+  if constexpr (Listing<COMMITTED_TAG>::is_committable) l.set_committed(l.begin() + 1);
+
+  std::string buffer;
+  l.format_to(std::back_inserter(buffer));
+  ASSERT_EQ(l, Listing<COMMITTED_TAG>::read(std::string_view(buffer)));
+
+  // parse errors report the line they occurred at.
+  buffer.replace(buffer.find("-12098"), 6, "amount");
+  try
+  {
+    Listing<COMMITTED_TAG>::read(std::string_view(buffer));
+    FAIL();
+  }
+  catch (ParseError const & e)
+  {
+    ASSERT_EQ(5, *boost::get_error_info<ParseError::errinfo_line_number>(e));
+  }
+
   return;
 }
 
@@ -312,3 +372,575 @@ template <typename COMMITTED_TAG> void io1::TestListing::TestMoveStatement(void)
   ASSERT_EQ(l_ref,l);
   return;
 }
+
+// Tests that the columnar view follows the mutations of the listing.
+template <typename COMMITTED_TAG> void io1::TestListing::TestColumns(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing the columnar view.");
+  l.add_statement(1_USD, "first", QDate{ 2024, 3, 1 });
+  l.add_statement(2_USD, "second", QDate{ 2024, 3, 2 });
+
+  auto const & columns = l.columns();
+  ASSERT_EQ(2, columns.size());
+  ASSERT_EQ(3_USD, columns.sum());
+
+  // additions are appended to the view.
+  l.add_statement(4_USD, "third", QDate{ 2024, 3, 3 });
+  ASSERT_EQ(3, l.columns().size());
+  ASSERT_EQ(7_USD, l.columns().sum());
+  ASSERT_EQ("third", l.columns().description(2));
+
+  // other mutations rebuild it.
+  l.alter_statement(l.begin(), 8_USD, "altered", QDate{ 2024, 3, 1 });
+  ASSERT_EQ(14_USD, l.columns().sum());
+  ASSERT_EQ("altered", l.columns().description(0));
+
+  l.erase_statement(l.begin() + 1);
+  ASSERT_EQ(12_USD, l.columns().sum());
+
+  l.swap_statements(l.begin(), l.begin() + 1);
+  ASSERT_EQ("third", l.columns().description(0));
+  return;
+}
+
+// Tests that the total amount follows the mutations of the listing.
+template <typename COMMITTED_TAG> void io1::TestListing::TestTotalAmount(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing the total amount.");
+  ASSERT_EQ(0_USD, l.total_amount());
+
+  for (int i = 0; 10 > i; ++i) l.add_statement(Money{ 100 * i }, "");
+  ASSERT_EQ(45_USD, l.total_amount());
+
+  l.erase_statement(l.begin() + 9);
+  ASSERT_EQ(36_USD, l.total_amount());
+
+  l.alter_statement(l.begin() + 8, 10_USD, "altered");
+  ASSERT_EQ(38_USD, l.total_amount());
+
+  auto const group = l.group_range("group", QDate::currentDate(), { l.begin() + 2, l.begin() + 5 });
+  ASSERT_EQ(38_USD, l.total_amount());
+
+  l.split_statement(group);
+  ASSERT_EQ(38_USD, l.total_amount());
+
+  std::stringstream s;
+  s << l;
+  Listing<COMMITTED_TAG> l_read;
+  s >> l_read;
+  ASSERT_EQ(38_USD, l_read.total_amount());
+
+  return;
+}
+
+// Tests date range queries on an unsorted listing.
+template <typename COMMITTED_TAG> void io1::TestListing::TestStatementsBetween(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing date range queries.");
+  l.add_statement(1_USD, "march", QDate{ 2024, 3, 15 });
+  l.add_statement(2_USD, "april", QDate{ 2024, 4, 1 });
+  l.add_statement(3_USD, "february", QDate{ 2024, 2, 29 });
+  l.add_statement(4_USD, "first of march", QDate{ 2024, 3, 1 });
+  l.add_statement(5_USD, "end of march", QDate{ 2024, 3, 31 });
+
+  auto const amounts = [](auto const & range) { std::vector<Money> result; for (auto const & statement : range) result.push_back(statement.amount()); return result; };
+
+  ASSERT_EQ((std::vector<Money>{ 4_USD, 1_USD, 5_USD }), amounts(l.statements_between(QDate{ 2024, 3, 1 }, QDate{ 2024, 3, 31 })));
+  ASSERT_TRUE(l.statements_between(QDate{ 2023, 3, 1 }, QDate{ 2023, 3, 31 }).empty());
+  ASSERT_EQ(5, l.statements_between(QDate{ 2024, 1, 1 }, QDate{ 2024, 12, 31 }).size());
+
+  // appended statements are inserted in the index, statements of the same date keep their listing order.
+  l.add_statement(6_USD, "another first of march", QDate{ 2024, 3, 1 });
+  ASSERT_EQ((std::vector<Money>{ 4_USD, 6_USD, 1_USD, 5_USD }), amounts(l.statements_between(QDate{ 2024, 3, 1 }, QDate{ 2024, 3, 31 })));
+
+  // erasing and moving statements update the index.
+  l.erase_statement(l.begin());
+  l.move_statement(l.begin() + 4, l.begin());
+  ASSERT_EQ((std::vector<Money>{ 6_USD, 4_USD, 5_USD }), amounts(l.statements_between(QDate{ 2024, 3, 1 }, QDate{ 2024, 3, 31 })));
+  ASSERT_EQ((std::vector<Money>{ 3_USD }), amounts(l.statements_between(QDate{ 2024, 2, 29 }, QDate{ 2024, 2, 29 })));
+
+  // after each kind of edit, queries match a stable sort of the listing by date.
+  auto const check = [&l, &amounts](QDate const & from, QDate const & to)
+  {
+    std::vector<Statement> expected;
+    for (auto const & statement : l.statements()) if (!(statement.date() < from) && !(to < statement.date())) expected.push_back(statement);
+    std::stable_sort(expected.begin(), expected.end(), [](Statement const & lhs, Statement const & rhs) { return lhs.date() < rhs.date(); });
+    ASSERT_EQ(amounts(expected), amounts(l.statements_between(from, to)));
+  };
+
+  std::uint64_t random = 42;
+  auto const next = [&random](std::size_t bound) { random = random * 6364136223846793005 + 1442695040888963407; return static_cast<std::size_t>(random >> 33) % bound; };
+  auto const item = [&l, &next] { return l.begin() + static_cast<std::ptrdiff_t>(next(l.statements().size())); };
+
+  l.set_journal_limit(1 << 20);
+  for (int i = 0; 300 > i; ++i)
+  {
+    switch (next(6))
+    {
+      case 0: l.add_statement(Money{ 100 + i }, "", QDate{ 2024, 3, 1 }.addDays(static_cast<qint64>(next(20)))); break; // few dates, many ties.
+      case 1: if (1 < l.statements().size()) l.erase_statement(item()); break;
+      case 2: l.move_statement(item(), item()); break;
+      case 3: l.swap_statements(item(), item()); break;
+      case 4: l.undo(); break;
+      default: l.redo(); break;
+    }
+    check(QDate{ 2024, 3, 5 }, QDate{ 2024, 3, 12 });
+    check(QDate{ 2024, 1, 1 }, QDate{ 2024, 12, 31 });
+  }
+
+  return;
+}
+
+template <typename COMMITTED_TAG> void io1::TestListing::TestIncrementalSort(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing incremental sorts.");
+  ASSERT_TRUE(l.is_sorted());
+
+  l.add_statement(1_USD, "first", QDate{ 2024, 1, 10 });
+  l.add_statement(2_USD, "second", QDate{ 2024, 1, 20 });
+  l.add_statement(3_USD, "same day", QDate{ 2024, 1, 20 });
+  ASSERT_TRUE(l.is_sorted());
+
+  // appended statements that are out of order are merged into the sorted prefix, after the statements of the same date.
+  l.add_statement(4_USD, "before the first", QDate{ 2024, 1, 5 });
+  l.add_statement(5_USD, "after the second", QDate{ 2024, 1, 20 });
+  l.add_statement(6_USD, "between", QDate{ 2024, 1, 15 });
+  ASSERT_FALSE(l.is_sorted());
+
+  auto const amounts = [](auto const & range) { std::vector<Money> result; for (auto const & statement : range) result.push_back(statement.amount()); return result; };
+
+  l.stable_sort();
+  ASSERT_TRUE(l.is_sorted());
+  ASSERT_EQ((std::vector<Money>{ 4_USD, 1_USD, 6_USD, 2_USD, 3_USD, 5_USD }), amounts(l));
+
+  // erasing keeps the listing sorted, other mutations only invalidate the end of the prefix.
+  l.erase_statement(l.begin() + 1);
+  ASSERT_TRUE(l.is_sorted());
+  l.swap_statements(l.begin() + 3, l.begin());
+  ASSERT_FALSE(l.is_sorted());
+  l.sort();
+  ASSERT_TRUE(l.is_sorted());
+  ASSERT_EQ((std::vector<Money>{ 4_USD, 6_USD }), amounts(boost::make_iterator_range(l.begin(), l.begin() + 2)));
+  ASSERT_EQ(5, l.statements().size());
+
+  // a listing that is read back is sorted if its statements are.
+  std::stringstream stream;
+  stream << l;
+  Listing<COMMITTED_TAG> l_read;
+  stream >> l_read;
+  ASSERT_TRUE(l_read.is_sorted());
+
+  return;
+}
+
+template <typename COMMITTED_TAG> void io1::TestListing::TestHandles(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing statement handles.");
+  ASSERT_EQ(l.end(), l.resolve(StatementHandle{}));
+
+  l.add_statement(1_USD, "one", QDate{ 2024, 1, 5 });
+  l.add_statement(2_USD, "two", QDate{ 2024, 1, 3 });
+  l.add_statement(3_USD, "three", QDate{ 2024, 1, 1 });
+  l.add_statement(4_USD, "four", QDate{ 2024, 1, 4 });
+
+  auto const one = l.handle(l.begin());
+  auto const three = l.handle(l.begin() + 2);
+  auto const four = l.handle(l.begin() + 3);
+  ASSERT_EQ(three, l.handle(l.begin() + 2)); // a statement has a single handle.
+
+  // handles follow their statement when others are added, moved or erased.
+  l.add_statement(5_USD, "five", QDate{ 2024, 1, 2 });
+  auto const five = l.handle(l.end() - 1);
+  l.move_statement(l.begin() + 3, l.begin());
+  ASSERT_EQ(4_USD, l.resolve(four)->amount());
+  ASSERT_EQ(1_USD, l.resolve(one)->amount());
+  l.erase_statement(l.begin() + 2);
+  ASSERT_EQ(3_USD, l.resolve(three)->amount());
+  ASSERT_EQ(l.begin() + 2, l.resolve(three));
+  l.swap_statements(l.begin(), l.begin() + 1);
+  ASSERT_EQ(l.begin() + 1, l.resolve(four));
+  ASSERT_EQ(5_USD, l.resolve(five)->amount());
+
+  // and when the listing is sorted.
+  l.stable_sort();
+  ASSERT_EQ(l.begin(), l.resolve(three));
+  ASSERT_EQ(l.begin() + 1, l.resolve(five));
+  ASSERT_EQ(l.begin() + 2, l.resolve(four));
+  ASSERT_EQ(l.begin() + 3, l.resolve(one));
+
+  // gathering a selection of handles.
+  auto const range = l.gather_selection(typename Listing<COMMITTED_TAG>::handle_selection{ three, four });
+  ASSERT_EQ(range.begin(), l.resolve(three));
+  ASSERT_EQ(range.begin() + 1, l.resolve(four));
+  ASSERT_EQ(l.begin(), l.resolve(five));
+
+  // grouped statements lose their handle, stale handles resolve to the end and are skipped by selections.
+  l.group_range("group", QDate{ 2024, 1, 1 }, range);
+  ASSERT_EQ(l.end(), l.resolve(three));
+  ASSERT_EQ(l.end(), l.resolve(four));
+  ASSERT_EQ(l.begin() + 2, l.resolve(one));
+  ASSERT_EQ(1, l.resolve(typename Listing<COMMITTED_TAG>::handle_selection{ three, one }).size());
+
+  // the split statement keeps its handle, which then designates the first entry.
+  auto const group = l.handle(l.begin() + 1);
+  l.split_statement(l.begin() + 1);
+  ASSERT_EQ(l.begin() + 1, l.resolve(group));
+  ASSERT_EQ(3_USD, l.resolve(group)->amount());
+  ASSERT_EQ(l.begin() + 3, l.resolve(one));
+
+  // released slots are reused with another generation.
+  l.release_handle(one);
+  ASSERT_EQ(l.end(), l.resolve(one));
+  auto const reused = l.handle(l.begin());
+  ASSERT_NE(one, reused);
+  ASSERT_EQ(l.end(), l.resolve(one));
+  ASSERT_EQ(l.begin(), l.resolve(reused));
+
+  return;
+}
+
+template <typename COMMITTED_TAG> void io1::TestListing::TestSelectionBitmap(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing bitmap selections.");
+  for (int i = 0; 10 > i; ++i) l.add_statement(Money{ i }, "");
+
+  auto const odd = l.select_if([](auto const & statement) { return 1 == statement.amount().data() % 2; });
+  ASSERT_EQ(10, odd.size());
+  ASSERT_EQ(5, odd.count());
+
+  // a bitmap selection is gathered as the equivalent statement selection.
+  auto l_ref = l;
+  typename Listing<COMMITTED_TAG>::statement_selection selection;
+  for (auto position : odd) selection.insert(l_ref.begin() + position);
+  auto const range_ref = l_ref.gather_selection(selection);
+
+  auto const range = l.gather_selection(odd);
+  ASSERT_EQ(l_ref, l);
+  ASSERT_EQ(range_ref.begin() - l_ref.begin(), range.begin() - l.begin());
+  ASSERT_EQ(5, range.size());
+  ASSERT_EQ(Money{ 1 }, range.begin()->amount());
+  ASSERT_EQ(Money{ 9 }, (range.end() - 1)->amount());
+
+  // an empty selection returns an empty range.
+  ASSERT_TRUE(l.gather_selection(SelectionBitmap(10)).empty());
+
+  return;
+}
+
+// Tests that a transaction gives the same listing as the equivalent calls.
+template <typename COMMITTED_TAG> void io1::TestListing::TestTransaction(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing transactions.");
+  for (int i = 0; 10 > i; ++i) l.add_statement(Money{ i }, "", QDate{ 2024, 1, 1 + i });
+  auto const seven = l.handle(l.begin() + 7);
+  auto const eight = l.handle(l.begin() + 8);
+  auto const nine = l.handle(l.begin() + 9);
+
+  auto l_ref = l;
+  auto const item_ref = [&l_ref](std::ptrdiff_t index) { return l_ref.begin() + index; };
+  l_ref.add_statement(Money{ 20 }, "appended", QDate{ 2023, 1, 1 });
+  l_ref.group_range("group", QDate{ 2024, 2, 1 }, boost::make_iterator_range(item_ref(7), item_ref(9)));
+  l_ref.move_statement(item_ref(5), item_ref(0));
+  l_ref.alter_statement(item_ref(5), Money{ 30 }, "altered", QDate{ 2024, 3, 1 });
+  l_ref.erase_statement(item_ref(3));
+  l_ref.erase_statement(item_ref(2));
+
+  auto transaction = l.transaction();
+  ASSERT_TRUE(transaction.empty());
+  transaction.erase(l.begin() + 1)
+    .move(l.begin() + 5, l.begin())
+    .erase(l.begin() + 2)
+    .alter(l.begin() + 4, Money{ 30 }, "altered", QDate{ 2024, 3, 1 })
+    .group("group", QDate{ 2024, 2, 1 }, boost::make_iterator_range(l.begin() + 7, l.begin() + 9))
+    .insert(l.end(), Money{ 20 }, "appended", QDate{ 2023, 1, 1 });
+  ASSERT_FALSE(transaction.empty());
+
+  // nothing happens until the transaction is committed.
+  ASSERT_EQ(10, l.statements().size());
+  transaction.commit();
+  ASSERT_TRUE(transaction.empty());
+
+  ASSERT_EQ(l_ref, l);
+  ASSERT_EQ(l_ref.total_amount(), l.total_amount());
+  ASSERT_FALSE(l.is_sorted());
+
+  // handles follow their statements unless they were grouped.
+  ASSERT_EQ(l.end(), l.resolve(seven));
+  ASSERT_EQ(l.end(), l.resolve(eight));
+  ASSERT_EQ(Money{ 9 }, l.resolve(nine)->amount());
+  ASSERT_EQ(l.end() - 2, l.resolve(nine));
+
+  // insertions before the same statement keep their order.
+  l.transaction().insert(l.begin(), Money{ 40 }, "first").insert(l.begin(), Money{ 41 }, "second").commit();
+  ASSERT_EQ(Money{ 40 }, l.begin()->amount());
+  ASSERT_EQ(Money{ 41 }, (l.begin() + 1)->amount());
+  ASSERT_EQ(Money{ 5 }, (l.begin() + 2)->amount());
+
+  // so do groups and insertions before the same statement.
+  auto const amount_of = [&l](std::ptrdiff_t index) { return (l.begin() + index)->amount(); };
+  l.transaction().insert(l.begin(), Money{ 50 }, "inserted first").group("grouped second", QDate{ 2024, 4, 1 }, boost::make_iterator_range(l.begin(), l.begin() + 2)).commit();
+  ASSERT_EQ(Money{ 50 }, amount_of(0));
+  ASSERT_EQ(Money{ 81 }, amount_of(1));
+  l.transaction().group("grouped first", QDate{ 2024, 4, 1 }, boost::make_iterator_range(l.begin(), l.begin() + 2)).insert(l.begin(), Money{ 60 }, "inserted second").commit();
+  ASSERT_EQ(Money{ 131 }, amount_of(0));
+  ASSERT_EQ(Money{ 60 }, amount_of(1));
+
+  // a statement cannot be edited twice, the rejected edit is not recorded.
+  auto const before = l;
+  auto twice = l.transaction();
+  twice.erase(l.begin() + 1).alter(l.begin() + 3, Money{ 70 }, "altered");
+  ASSERT_THROW(twice.alter(l.begin() + 1, Money{ 71 }, "altered twice"), StatementEditedTwice);
+  ASSERT_THROW(twice.move(l.begin() + 3, l.begin()), StatementEditedTwice);
+  ASSERT_THROW(twice.group("overlapping", QDate{ 2024, 4, 1 }, boost::make_iterator_range(l.begin() + 2, l.begin() + 4)), StatementEditedTwice);
+  twice.erase(l.begin() + 2).commit();
+  ASSERT_EQ(before.statements().size() - 2, l.statements().size());
+  ASSERT_EQ(before.total_amount() - (before.begin() + 1)->amount() - (before.begin() + 2)->amount() - (before.begin() + 3)->amount() + Money{ 70 }, l.total_amount());
+
+  return;
+}
+
+// Tests that undoing every edit restores each intermediate listing, and that redoing them restores the last one.
+template <typename COMMITTED_TAG> void io1::TestListing::TestJournal(void) const
+{
+  Listing<COMMITTED_TAG> l("Testing the journal.");
+  for (int i = 0; 6 > i; ++i) l.add_statement(Money{ i }, "", QDate{ 2024, 1, 1 + i });
+
+  // disabled by default.
+  ASSERT_FALSE(l.can_undo());
+  l.add_statement(6_USD, "");
+  ASSERT_FALSE(l.can_undo());
+  ASSERT_FALSE(l.undo());
+
+  l.set_journal_limit(1 << 20);
+  std::vector<Listing<COMMITTED_TAG>> states{ l };
+  auto const item = [&l](std::ptrdiff_t index) { return l.begin() + index; };
+
+  l.add_statement(7_USD, "added");
+  states.push_back(l);
+  l.erase_statement(item(2));
+  states.push_back(l);
+  l.alter_statement(item(1), 10_USD, "altered", QDate{ 2024, 2, 1 });
+  states.push_back(l);
+  l.group_range("group", QDate{ 2024, 3, 1 }, boost::make_iterator_range(item(2), item(5)));
+  states.push_back(l);
+  l.move_statement(item(0), item(3));
+  states.push_back(l);
+  l.move_statement(item(4), item(1));
+  states.push_back(l);
+  l.swap_statements(item(0), item(2));
+  states.push_back(l);
+  ASSERT_TRUE(item(0)->is_composed());
+  l.split_statement(item(0));
+  states.push_back(l);
+  ASSERT_NE(states.front(), l);
+
+  for (auto state = states.rbegin() + 1; states.rend() != state; ++state)
+  {
+    ASSERT_TRUE(l.undo());
+    ASSERT_EQ(*state, l);
+    ASSERT_EQ(state->total_amount(), l.total_amount());
+  }
+  ASSERT_FALSE(l.undo());
+
+  for (auto state = states.begin() + 1; states.end() != state; ++state)
+  {
+    ASSERT_TRUE(l.redo());
+    ASSERT_EQ(*state, l);
+  }
+  ASSERT_FALSE(l.redo());
+
+  // the arguments of an alteration may refer to the altered statement, and a failed alteration changes nothing.
+  l.add_statement(8_USD, "kept description", QDate{ 2024, 4, 1 });
+  auto const before = l;
+  l.alter_statement(l.end() - 1, 9_USD, (l.end() - 1)->description(), (l.end() - 1)->date());
+  ASSERT_EQ(QString("kept description"), (l.end() - 1)->description());
+  ASSERT_EQ((QDate{ 2024, 4, 1 }), (l.end() - 1)->date());
+  ASSERT_EQ(9_USD, (l.end() - 1)->amount());
+
+  auto const altered = l;
+  auto const journal_size = l.journal_size();
+  ASSERT_THROW(l.alter_statement(l.end() - 1, QString("empty group"), QDate{ 2024, 4, 1 }, std::vector<Entry>{}), std::range_error);
+  ASSERT_EQ(altered, l);
+  ASSERT_EQ(altered.total_amount(), l.total_amount());
+  ASSERT_EQ(journal_size, l.journal_size());
+
+  ASSERT_TRUE(l.undo());
+  ASSERT_EQ(before, l);
+  ASSERT_EQ(QString("kept description"), (l.end() - 1)->description());
+  ASSERT_TRUE(l.redo());
+  ASSERT_EQ(altered, l);
+
+  // a new edit after an undo cannot be followed by a redo.
+  ASSERT_TRUE(l.undo());
+  l.erase_statement(item(0));
+  ASSERT_FALSE(l.can_redo());
+
+  // sorting clears the journal.
+  l.stable_sort();
+  ASSERT_FALSE(l.can_undo());
+  ASSERT_EQ(0, l.journal_size());
+
+  // the text of the statements a record holds counts against the limit.
+  l.add_statement(1_USD, QString::fromStdString(std::string(1000, 'x')), QDate{ 2024, 5, 1 });
+  auto const size_before_erase = l.journal_size();
+  l.erase_statement(l.end() - 1);
+  ASSERT_LE(size_before_erase + 1000, l.journal_size());
+
+  // the oldest edits are forgotten to honor the limit.
+  l.set_journal_limit(1);
+  l.erase_statement(item(0));
+  ASSERT_FALSE(l.can_undo());
+  ASSERT_EQ(0, l.journal_size());
+
+  // undoing an erase, a grouping or a split gives the statements their handles back, until the journal forgets the edit.
+  l.set_journal_limit(1 << 20);
+  auto const first = l.handle(item(0));
+  auto const second = l.handle(item(1));
+  l.erase_statement(item(0));
+  ASSERT_EQ(l.end(), l.resolve(first));
+  ASSERT_TRUE(l.undo());
+  ASSERT_EQ(item(0), l.resolve(first));
+  ASSERT_TRUE(l.redo());
+  ASSERT_EQ(l.end(), l.resolve(first));
+  ASSERT_TRUE(l.undo());
+
+  l.group_range("group", QDate{ 2024, 6, 1 }, boost::make_iterator_range(item(0), item(2)));
+  ASSERT_EQ(l.end(), l.resolve(second));
+  auto const group = l.handle(item(0));
+  l.split_statement(item(0));
+  ASSERT_EQ(item(0), l.resolve(group));
+  ASSERT_TRUE(l.undo());
+  ASSERT_EQ(item(0), l.resolve(group));
+  ASSERT_TRUE(l.undo());
+  ASSERT_EQ(item(0), l.resolve(first));
+  ASSERT_EQ(item(1), l.resolve(second));
+  ASSERT_EQ(l.end(), l.resolve(group));
+  ASSERT_TRUE(l.redo());
+  ASSERT_EQ(item(0), l.resolve(group));
+  ASSERT_EQ(l.end(), l.resolve(first));
+
+  l.clear_journal();
+  ASSERT_EQ(l.end(), l.resolve(first));
+  ASSERT_NE(first, l.handle(item(0)));
+  ASSERT_EQ(item(0), l.resolve(group));
+
+  return;
+}
+
+void io1::TestListing::TestCommitStates(void) const
+{
+  Listing<committable_tag> l{ "Testing commit states." };
+  for (int i = 0; 130 > i; ++i) l.add_statement(Money{ i }, "");
+  ASSERT_EQ(0, l.committed_count());
+
+  // the bitmap follows set_committed and add_statement.
+  l.set_committed(l.begin() + 1);
+  l.set_committed(l.begin() + 64);
+  l.add_statement(1_USD, "")->set_committed();
+  ASSERT_TRUE((l.end() - 1)->is_committed());
+  l.set_committed(l.begin() + 129);
+  l.set_committed(l.begin() + 129, false);
+  ASSERT_TRUE(l.is_committed(l.begin() + 64));
+  ASSERT_EQ(3, l.committed_count());
+  ASSERT_EQ((std::vector<std::size_t>{ 1, 64, 130 }), std::vector<std::size_t>(l.committed_statements().begin(), l.committed_statements().end()));
+  ASSERT_EQ(128, l.uncommitted_statements().count());
+
+  auto const committed_positions = [&l] { return std::vector<std::size_t>(l.committed_statements().begin(), l.committed_statements().end()); };
+  auto const committed_amounts = [&l]
+  {
+    std::vector<Money> amounts;
+    for (auto position : l.committed_statements()) amounts.push_back(l.begin()[position].amount());
+    return amounts;
+  };
+
+  // the columns follow set_committed.
+  ASSERT_TRUE(l.columns().is_committed(64));
+  l.set_committed(l.begin() + 2);
+  ASSERT_TRUE(l.columns().is_committed(2));
+  l.set_committed(l.begin() + 2, false);
+  ASSERT_FALSE(l.columns().is_committed(2));
+  (l.begin() + 3)->set_committed();
+  ASSERT_TRUE(l.columns().is_committed(3));
+  (l.begin() + 3)->set_committed(false);
+  ASSERT_FALSE(l.is_committed(l.begin() + 3));
+
+  // the commit states move along with the statements.
+  l.set_journal_limit(1 << 20);
+  l.erase_statement(l.begin());
+  ASSERT_EQ((std::vector<std::size_t>{ 0, 63, 129 }), committed_positions());
+  ASSERT_TRUE(l.undo());
+  ASSERT_EQ((std::vector<std::size_t>{ 1, 64, 130 }), committed_positions());
+
+  l.move_statement(l.begin() + 1, l.begin() + 70);
+  ASSERT_EQ((std::vector<Money>{ Money{ 64 }, Money{ 1 }, 1_USD }), committed_amounts());
+  ASSERT_TRUE(l.undo());
+  l.swap_statements(l.begin() + 64, l.begin() + 3);
+  ASSERT_EQ((std::vector<std::size_t>{ 1, 3, 130 }), committed_positions());
+  ASSERT_EQ((std::vector<Money>{ Money{ 1 }, Money{ 64 }, 1_USD }), committed_amounts());
+  ASSERT_TRUE(l.undo());
+
+  l.alter_statement(l.begin() + 64, 2_USD, "altered");
+  ASSERT_FALSE(l.is_committed(l.begin() + 64));
+  ASSERT_TRUE(l.undo());
+  ASSERT_TRUE((l.begin() + 64)->is_committed());
+
+  l.transaction().erase(l.begin()).move(l.begin() + 64, l.begin()).insert(l.begin() + 2, 3_USD, "inserted").commit();
+  ASSERT_EQ((std::vector<Money>{ Money{ 64 }, Money{ 1 }, 1_USD }), committed_amounts());
+  ASSERT_EQ((std::vector<std::size_t>{ 0, 1, 130 }), committed_positions());
+
+  // sorts, reads and comparisons see the commit states as well.
+  for (std::size_t i = 0; l.statements().size() > i; ++i) l.alter_statement(l.begin() + i, l.begin()[i].amount(), "", QDate{ 2020, 1, 1 }.addDays(static_cast<qint64>(l.statements().size() - i)));
+  l.set_committed(l.begin() + 5);
+  l.sort();
+  ASSERT_EQ((std::vector<std::size_t>{ l.statements().size() - 6 }), committed_positions());
+
+  std::stringstream stream;
+  stream << l;
+  auto const read = Listing<committable_tag>::read(stream);
+  ASSERT_EQ(l, read);
+  ASSERT_TRUE(read.is_committed(read.end() - 6));
+  l.set_committed(l.end() - 6, false);
+  ASSERT_NE(l, read);
+
+  return;
+}
+
+void io1::TestListing::TestExtractCommitted(void) const
+{
+  Listing<committable_tag> l{ "Testing committed statements extraction." };
+  l.add_statement(1_USD, "first", QDate{ 2020,1,1 });
+  l.add_statement(2_USD, "second", QDate{ 2020,1,3 });
+  l.add_statement(4_USD, "third", QDate{ 2020,1,2 });
+  l.add_statement(8_USD, "fourth", QDate{ 2020,1,4 });
+  l.add_statement(16_USD, "fifth", QDate{ 2020,1,5 });
+  l.set_journal_limit(1 << 20);
+  for (auto const position : { 1, 2, 3 }) l.set_committed(l.begin() + position);
+
+  auto const kept = l.handle(l.begin() + 4);
+  auto const extracted_handle = l.handle(l.begin() + 2);
+
+  // the committed statements are moved out in order, the others keep theirs.
+  auto const extracted = l.extract_committed("extracted");
+  ASSERT_EQ("extracted", extracted.name());
+  ASSERT_EQ(14_USD, extracted.total_amount());
+  ASSERT_EQ((std::vector<std::string>{ "second", "third", "fourth" }), (std::vector<std::string>{ extracted.begin()[0].description().toStdString(), extracted.begin()[1].description().toStdString(), extracted.begin()[2].description().toStdString() }));
+  ASSERT_FALSE(extracted.is_sorted());
+
+  ASSERT_EQ(2, l.statements().size());
+  ASSERT_EQ(17_USD, l.total_amount());
+  ASSERT_EQ("first", l.begin()->description().toStdString());
+  ASSERT_EQ("fifth", (l.begin() + 1)->description().toStdString());
+  ASSERT_TRUE(l.is_sorted());
+  ASSERT_EQ(0, l.committed_count());
+  ASSERT_FALSE(l.can_undo());
+
+  // handles of the remaining statements follow them, the others are stale.
+  ASSERT_EQ(l.begin() + 1, l.resolve(kept));
+  ASSERT_EQ(l.end(), l.resolve(extracted_handle));
+
+  // nothing left to extract.
+  ASSERT_TRUE(l.extract_committed("empty").empty());
+  ASSERT_EQ(2, l.statements().size());
+
+  return;
+}
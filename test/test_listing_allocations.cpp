@@ -0,0 +1,65 @@
+/// \file test_listing_allocations.cpp
+/// The global operator new is replaced to count allocations, which affects the whole executable, so these tests are built apart.
+#include "gtest/gtest.h"
+#include "listing.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  std::size_t allocation_count = 0; // counts every call to the global operator new.
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // the replaced operator new allocates with std::malloc.
+#endif
+
+void * operator new(std::size_t size)
+{
+  ++allocation_count;
+  if (auto const memory = std::malloc(0 == size ? 1 : size)) return memory;
+  throw std::bad_alloc{};
+}
+
+void * operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void * memory) noexcept { std::free(memory); }
+void operator delete(void * memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void * memory) noexcept { std::free(memory); }
+void operator delete[](void * memory, std::size_t) noexcept { std::free(memory); }
+
+namespace io1 {
+
+  class TestListingAllocations: public ::testing::Test
+  {
+  public:
+    template <typename committed_tag> void TestGroupSplitAllocations(void) const;
+  };
+
+  TEST_F(TestListingAllocations, TestGroupSplitAllocations) { return TestGroupSplitAllocations<non_committable_tag>(); };
+  TEST_F(TestListingAllocations, TestCommittableGroupSplitAllocations) { return TestGroupSplitAllocations<committable_tag>(); };
+}
+
+// Tests that grouping and splitting move entries instead of copying them, the number of allocations does not depend on the number of entries.
+template <typename COMMITTED_TAG> void io1::TestListingAllocations::TestGroupSplitAllocations(void) const
+{
+  std::size_t const nb_entries = 24;
+
+  // descriptions are long enough to be allocated when copied.
+  Listing<COMMITTED_TAG> l("Testing allocations.");
+  for (std::size_t i = 0; nb_entries > i; ++i) l.add_statement(Money{ static_cast<int>(i) }, "a description that does not fit in a small string buffer", QDate{ 2024, 1, 1 });
+  auto const l_ref = l;
+
+  auto allocations = allocation_count;
+  auto const group = l.group_range("group", QDate{ 2024, 1, 1 }, l.statements());
+  ASSERT_GT(5, allocation_count - allocations); // the entries, the group, its main entry and its description.
+  ASSERT_EQ(nb_entries, group->entry_count());
+  ASSERT_EQ(l_ref.total_amount(), l.total_amount());
+
+  allocations = allocation_count;
+  auto const split = l.split_statement(group);
+  ASSERT_GT(3, allocation_count - allocations); // the statements and a buffer for the entries, which are moved.
+  ASSERT_EQ(nb_entries, split.size());
+  ASSERT_EQ(l_ref, l);
+
+  return;
+}
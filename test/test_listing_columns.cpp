@@ -0,0 +1,73 @@
+/// \file test_listing_columns.cpp
+#include "gtest/gtest.h"
+#include "io1/listing_columns.hpp"
+
+namespace io1 {
+
+  class TestListingColumns : public ::testing::Test
+  {
+  public:
+    void TestColumns(void) const;
+    void TestKernels(void) const;
+  };
+
+  TEST_F(TestListingColumns, TestColumns) { return TestColumns(); };
+  TEST_F(TestListingColumns, TestKernels) { return TestKernels(); };
+}
+
+void io1::TestListingColumns::TestColumns(void) const
+{
+  using namespace std::chrono;
+
+  ListingColumns columns;
+  ASSERT_TRUE(columns.empty());
+
+  for (int i = 0; 100 > i; ++i)
+    columns.push_back(Entry{ Money{ i }, "description " + std::to_string(i), sys_days{ 1970y / January / 1d } + days{ i } }, 0 == i % 3);
+
+  ASSERT_EQ(100, columns.size());
+  ASSERT_EQ(42, columns.days()[42]);
+  ASSERT_EQ(42, columns.amounts()[42]);
+  ASSERT_EQ("description 42", columns.description(42));
+  ASSERT_EQ("description 0", columns.description(0));
+  ASSERT_TRUE(columns.is_committed(99));
+  ASSERT_FALSE(columns.is_committed(98));
+  ASSERT_EQ(34, columns.committed_count());
+  ASSERT_EQ(2018y / July / 28d, ListingColumns::to_date(ListingColumns::to_day(2018y / July / 28d)));
+
+  columns.clear();
+  ASSERT_TRUE(columns.empty());
+  ASSERT_EQ(0, columns.committed_count());
+  return;
+}
+
+void io1::TestListingColumns::TestKernels(void) const
+{
+  using namespace std::chrono;
+
+  std::vector<Entry> entries;
+  entries.emplace_back(-12.34_USD, "", 2024y / March / 31d);
+  entries.emplace_back(100_USD, "", 2024y / March / 1d);
+  entries.emplace_back(7_USD, "", 2024y / February / 29d);
+  entries.emplace_back(-50_USD, "", 2024y / April / 1d);
+  entries.emplace_back(3_USD, "", 2024y / March / 15d);
+
+  ListingColumns columns;
+  for (auto const & entry : entries) columns.push_back(entry, false);
+
+  ASSERT_EQ(47.66_USD, columns.sum());
+  ASSERT_EQ(90.66_USD, columns.sum(2024y / March / 1d, 2024y / March / 31d));
+  ASSERT_EQ(0_USD, columns.sum(2025y / March / 1d, 2025y / March / 31d));
+
+  auto const [min_amount, max_amount] = columns.minmax_amount();
+  ASSERT_EQ(-50_USD, min_amount);
+  ASSERT_EQ(100_USD, max_amount);
+
+  auto const [min_day, max_day] = columns.minmax_day();
+  ASSERT_EQ(2024y / February / 29d, ListingColumns::to_date(min_day));
+  ASSERT_EQ(2024y / April / 1d, ListingColumns::to_date(max_day));
+
+  ASSERT_EQ((std::vector<std::uint32_t>{ 0, 1, 4 }), columns.filter(2024y / March / 1d, 2024y / March / 31d));
+  ASSERT_TRUE(columns.filter(2023y / March / 1d, 2023y / March / 31d).empty());
+  return;
+}
@@ -0,0 +1,61 @@
+/// \file test_parallel_sort.cpp
+#include "gtest/gtest.h"
+#include "io1/parallel_sort.hpp"
+#include <random>
+#include <utility>
+
+namespace io1 {
+
+  class TestParallelSort : public ::testing::Test
+  {
+  public:
+    void TestStability(void) const;
+    void TestSmallRanges(void) const;
+  };
+
+  TEST_F(TestParallelSort, TestStability) { return TestStability(); };
+  TEST_F(TestParallelSort, TestSmallRanges) { return TestSmallRanges(); };
+}
+
+// Tests that the parallel sorts match std::stable_sort for thread counts that do and do not divide the size.
+void io1::TestParallelSort::TestStability(void) const
+{
+  std::mt19937 generator{ 42 };
+  std::uniform_int_distribution<int> distribution{ 0, 1000 }; // many duplicate keys.
+
+  std::vector<std::pair<int, std::size_t>> values(5 * detail::parallel_sort_min_chunk + 17);
+  for (std::size_t i = 0; values.size() > i; ++i) values[i] = { distribution(generator), i };
+
+  auto const by_key = [](auto const & lhs, auto const & rhs) { return lhs.first < rhs.first; };
+  auto expected = values;
+  std::stable_sort(expected.begin(), expected.end(), by_key);
+
+  for (unsigned thread_count : { 1u, 2u, 3u, 4u, 5u, 64u })
+  {
+    auto actual = values;
+    parallel_stable_sort(actual.begin(), actual.end(), by_key, thread_count);
+    ASSERT_EQ(expected, actual) << thread_count << " threads";
+
+    actual = values;
+    parallel_sort(actual.begin(), actual.end(), by_key, thread_count);
+    ASSERT_TRUE(std::is_sorted(actual.begin(), actual.end(), by_key)) << thread_count << " threads";
+  }
+
+  return;
+}
+
+void io1::TestParallelSort::TestSmallRanges(void) const
+{
+  std::vector<int> values;
+  parallel_stable_sort(values.begin(), values.end(), std::less<>{}, 8);
+  ASSERT_TRUE(values.empty());
+
+  values = { 3, 1, 2 };
+  parallel_stable_sort(values.begin(), values.end(), std::less<>{}, 8);
+  ASSERT_EQ((std::vector<int>{ 1, 2, 3 }), values);
+
+  parallel_sort(values.begin(), values.end(), std::greater<>{}, 0);
+  ASSERT_EQ((std::vector<int>{ 3, 2, 1 }), values);
+
+  return;
+}
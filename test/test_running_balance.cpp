@@ -0,0 +1,58 @@
+/// \file test_running_balance.cpp
+#include "gtest/gtest.h"
+#include "io1/running_balance.hpp"
+#include <random>
+
+namespace io1 {
+
+  class TestRunningBalance : public ::testing::Test
+  {
+  public:
+    void TestKernels(void) const;
+    void TestColumns(void) const;
+  };
+
+  TEST_F(TestRunningBalance, TestKernels) { return TestKernels(); };
+  TEST_F(TestRunningBalance, TestColumns) { return TestColumns(); };
+}
+
+// Tests that the dispatched kernel matches the scalar one for every block remainder.
+void io1::TestRunningBalance::TestKernels(void) const
+{
+  std::mt19937_64 generator{ 42 };
+  std::uniform_int_distribution<balance_type> distribution{ -1'000'000, 1'000'000 };
+
+  for (std::size_t size = 0; 67 > size; ++size)
+  {
+    std::vector<balance_type> amounts(size);
+    for (auto & amount : amounts) amount = distribution(generator);
+
+    std::vector<balance_type> expected(size), actual(size);
+    running_balance_scalar(amounts, 1234, expected);
+    running_balance(amounts, 1234, actual);
+    ASSERT_EQ(expected, actual);
+
+    // computing in place is allowed.
+    running_balance(amounts, 1234, amounts);
+    ASSERT_EQ(expected, amounts);
+  }
+
+  std::vector<balance_type> const amounts{ 1, 2, 3, 4, 5 };
+  std::vector<balance_type> balances(amounts.size());
+  running_balance(amounts, 10, balances);
+  ASSERT_EQ((std::vector<balance_type>{ 11, 13, 16, 20, 25 }), balances);
+
+  return;
+}
+
+void io1::TestRunningBalance::TestColumns(void) const
+{
+  ListingColumns columns;
+  columns.push_back(Entry{ 12.5_USD }, false);
+  columns.push_back(Entry{ -2.5_USD }, false);
+  columns.push_back(Entry{ 100_USD }, false);
+
+  ASSERT_EQ((std::vector<balance_type>{ 1250 + 10000, -250 + 1250 + 10000, 10000 + 1250 - 250 + 10000 }), columns.running_balances(100_USD));
+  ASSERT_TRUE(ListingColumns{}.running_balances(100_USD).empty());
+  return;
+}
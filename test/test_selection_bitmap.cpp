@@ -0,0 +1,129 @@
+/// \file test_selection_bitmap.cpp
+#include "gtest/gtest.h"
+#include "io1/selection_bitmap.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace io1 {
+
+  class TestSelectionBitmap : public ::testing::Test
+  {
+  public:
+    void TestSetReset(void) const;
+    void TestIteration(void) const;
+    void TestInsertErase(void) const;
+  };
+
+  TEST_F(TestSelectionBitmap, TestSetReset) { return TestSetReset(); };
+  TEST_F(TestSelectionBitmap, TestIteration) { return TestIteration(); };
+  TEST_F(TestSelectionBitmap, TestInsertErase) { return TestInsertErase(); };
+}
+
+void io1::TestSelectionBitmap::TestSetReset(void) const
+{
+  SelectionBitmap selection(130);
+  ASSERT_EQ(130, selection.size());
+  ASSERT_TRUE(selection.none());
+  ASSERT_EQ(0, selection.count());
+
+  selection.set(0);
+  selection.set(64);
+  selection.set(129);
+  ASSERT_TRUE(selection.test(64));
+  ASSERT_FALSE(selection.test(63));
+  ASSERT_EQ(3, selection.count());
+
+  selection.reset(64);
+  ASSERT_FALSE(selection.test(64));
+  ASSERT_EQ(2, selection.count());
+
+  // bits past the last statement are never set.
+  selection.set_all();
+  ASSERT_EQ(130, selection.count());
+  ASSERT_EQ(129, selection.find_last());
+
+  selection.clear();
+  ASSERT_TRUE(selection.none());
+
+  // flipping leaves the bits past the last statement cleared.
+  selection.set(5);
+  selection.flip();
+  ASSERT_EQ(129, selection.count());
+  ASSERT_FALSE(selection.test(5));
+
+  selection.push_back(true);
+  selection.push_back(false);
+  ASSERT_EQ(132, selection.size());
+  ASSERT_EQ(130, selection.count());
+  ASSERT_TRUE(selection.test(130));
+
+  return;
+}
+
+// Tests that iterating yields the selected positions in increasing order, across word boundaries.
+void io1::TestSelectionBitmap::TestIteration(void) const
+{
+  SelectionBitmap empty;
+  ASSERT_EQ(empty.begin(), empty.end());
+  ASSERT_EQ(0, empty.find_first());
+  ASSERT_EQ(0, empty.find_last());
+
+  SelectionBitmap selection(200);
+  ASSERT_EQ(selection.begin(), selection.end());
+  ASSERT_EQ(200, selection.find_first());
+  ASSERT_EQ(200, selection.find_last());
+
+  std::vector<std::size_t> const positions{ 3, 63, 64, 65, 127, 128, 199 };
+  for (auto position : positions) selection.set(position);
+
+  ASSERT_EQ(positions, std::vector<std::size_t>(selection.begin(), selection.end()));
+  ASSERT_EQ(3, selection.find_first());
+  ASSERT_EQ(127, selection.find_next(66));
+  ASSERT_EQ(199, selection.find_last());
+
+  return;
+}
+
+// Tests that inserting and erasing keep the bits in line with a vector of bools, at every alignment.
+void io1::TestSelectionBitmap::TestInsertErase(void) const
+{
+  SelectionBitmap selection;
+  std::vector<bool> expected;
+  auto const check = [&]
+  {
+    ASSERT_EQ(expected.size(), selection.size());
+    for (std::size_t i = 0; expected.size() > i; ++i) ASSERT_EQ(expected[i], selection.test(i)) << i;
+    ASSERT_EQ(static_cast<std::size_t>(std::count(expected.begin(), expected.end(), true)), selection.count());
+  };
+
+  std::uint64_t random = 42;
+  auto const next = [&random](std::size_t bound) { random = random * 6364136223846793005 + 1442695040888963407; return static_cast<std::size_t>(random >> 33) % bound; };
+
+  for (int i = 0; 500 > i; ++i)
+  {
+    auto const position = next(expected.size() + 1);
+    if (0 == next(3) && !expected.empty())
+    {
+      auto const last = position + next(std::min<std::size_t>(expected.size() - std::min(position, expected.size()) + 1, 150));
+      auto const first = std::min(position, expected.size());
+      auto const end = std::min(last, expected.size());
+      selection.erase(first, end);
+      expected.erase(expected.begin() + static_cast<std::ptrdiff_t>(first), expected.begin() + static_cast<std::ptrdiff_t>(end));
+    }
+    else
+    {
+      auto const count = next(150);
+      bool const selected = 0 == next(2);
+      selection.insert(position, count, selected);
+      expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(position), count, selected);
+    }
+    check();
+  }
+
+  // the bits past the last statement stay cleared, equal selections compare equal.
+  SelectionBitmap same(selection.size());
+  for (auto position : selection) same.set(position);
+  ASSERT_EQ(same, selection);
+
+  return;
+}
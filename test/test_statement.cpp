@@ -14,11 +14,15 @@ namespace io1 {
     void TestReadWrite(void) const;
     void TestReadWriteComittable(void) const;
     void TestFailedReadWriteComposed(void) const;
+    void TestFormatTo(void) const;
+    void TestMoveEntries(void) const;
   };
 
   TEST_F(TestStatement, TestReadWrite) { return TestReadWrite(); };
   TEST_F(TestStatement, TestReadWriteComittable) { return TestReadWriteComittable(); };
   TEST_F(TestStatement, TestFailedReadWriteComposed) { return TestFailedReadWriteComposed(); };
+  TEST_F(TestStatement, TestFormatTo) { return TestFormatTo(); };
+  TEST_F(TestStatement, TestMoveEntries) { return TestMoveEntries(); };
 }
 
 void io1::TestStatement::TestReadWrite(void) const
@@ -118,3 +122,48 @@ void io1::TestStatement::TestFailedReadWriteComposed(void) const
 
   return;
 }
+
+void io1::TestStatement::TestFormatTo(void) const
+{
+  std::vector<Entry> entries;
+  entries.emplace_back(12_USD, "First entry", QDate{ 2018, 7, 28 });
+  entries.emplace_back(-2.5_USD, "Second entry", QDate{ 2018, 7, 29 });
+  CommittableStatement s{ "A composed statement", QDate{ 2018, 7, 31 }, std::move(entries) };
+  s.set_committed();
+
+  std::string buffer;
+  s.format_to(std::back_inserter(buffer));
+  ASSERT_EQ(
+    "# 2018-07-31950       A composed statement\n"
+    "  - 2018-07-281200      First entry\n"
+    "  - 2018-07-29-250      Second entry\n", buffer);
+
+  std::stringstream stream;
+  stream << s;
+  ASSERT_EQ(buffer, stream.str());
+
+  return;
+}
+
+void io1::TestStatement::TestMoveEntries(void) const
+{
+  std::vector<Entry> entries;
+  entries.emplace_back(12_USD, "First entry", QDate{ 2018, 7, 28 });
+  entries.emplace_back(-2.5_USD, "Second entry", QDate{ 2018, 7, 29 });
+  auto const expected = entries;
+  Statement composed{ "A composed statement", QDate{ 2018, 7, 31 }, std::move(entries) };
+
+  // a composed statement gives its composed entries.
+  std::vector<Entry> moved;
+  composed.move_entries_to(std::back_inserter(moved));
+  ASSERT_EQ(expected, moved);
+
+  // a single entry statement gives its main entry.
+  Statement single{ expected.front() };
+  moved.clear();
+  single.move_entries_to(std::back_inserter(moved));
+  ASSERT_EQ(1, moved.size());
+  ASSERT_EQ(expected.front(), moved.front());
+
+  return;
+}